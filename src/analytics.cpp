@@ -0,0 +1,187 @@
+#include "analytics.h"
+#include "database.h"
+
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QVariant>
+#include <algorithm>
+#include <limits>
+
+QMutex Analytics::mutex;
+bool Analytics::loaded = false;
+qint64 Analytics::origin = 0;
+QHash<int, int> Analytics::index;
+QVector<int> Analytics::pairIds, Analytics::sessions, Analytics::minCount, Analytics::maxCount;
+QVector<double> Analytics::sumX, Analytics::sumY, Analytics::sumXX, Analytics::sumXY;
+QVector<qint64> Analytics::lastTime;
+
+// milliseconds per day
+static const double DAY = 86400000.;
+
+void Analytics::load()
+{
+    // build all aggregates in a single pass over chordcount
+    Statement query("SELECT chords_id, time, count FROM chordcount");
+    if (!query->exec())
+        return;
+
+    // start from scratch
+    QMutexLocker locker(&mutex);
+    origin = QDateTime::currentMSecsSinceEpoch();
+    index.clear();
+    for (auto col : {&pairIds, &sessions, &minCount, &maxCount})
+        col->clear();
+    for (auto col : {&sumX, &sumY, &sumXX, &sumXY})
+        col->clear();
+    lastTime.clear();
+
+    // accumulate
+    while (query->next()) {
+        int i = column(query->value(0).toInt());
+        qint64 time = query->value(1).toLongLong();
+        int count = query->value(2).toInt();
+        double x = (time - origin) / DAY;
+        sessions[i]++;
+        minCount[i] = std::min(minCount[i], count);
+        maxCount[i] = std::max(maxCount[i], count);
+        sumX[i] += x;
+        sumY[i] += count;
+        sumXX[i] += x * x;
+        sumXY[i] += x * count;
+        lastTime[i] = std::max(lastTime[i], time);
+    }
+    loaded = true;
+}
+
+bool Analytics::isLoaded()
+{
+    QMutexLocker locker(&mutex);
+    return loaded;
+}
+
+void Analytics::countAdded(const ChordCount &count)
+{
+    // nothing to update before first load
+    QMutexLocker locker(&mutex);
+    if (!loaded)
+        return;
+
+    // add to aggregates
+    int i = column(count.chords_id);
+    double x = (count.time - origin) / DAY;
+    sessions[i]++;
+    minCount[i] = std::min(minCount[i], count.count);
+    maxCount[i] = std::max(maxCount[i], count.count);
+    sumX[i] += x;
+    sumY[i] += count.count;
+    sumXX[i] += x * x;
+    sumXY[i] += x * count.count;
+    lastTime[i] = std::max(lastTime[i], count.time);
+}
+
+void Analytics::countRemoved(const ChordCount &count)
+{
+    // nothing to update before first load
+    qint64 from;
+    {
+        QMutexLocker locker(&mutex);
+        if (!loaded || !index.contains(count.chords_id))
+            return;
+        from = origin;
+    }
+
+    // subtracting from the sums would cancel badly over time, and extremes can't be subtracted at all,
+    // so fetch everything again, without blocking readers during the query
+    auto sums = fetchSums(count.chords_id, from);
+
+    // replace aggregates
+    QMutexLocker locker(&mutex);
+    int i = index[count.chords_id];
+    sessions[i] = sums.sessions;
+    minCount[i] = sums.min;
+    maxCount[i] = sums.max;
+    sumX[i] = sums.sumX;
+    sumY[i] = sums.sumY;
+    sumXX[i] = sums.sumXX;
+    sumXY[i] = sums.sumXY;
+    lastTime[i] = sums.last_time;
+}
+
+QList<PairStats> Analytics::pairs()
+{
+    // all pairs with counts
+    QMutexLocker locker(&mutex);
+    QList<PairStats> stats;
+    for (int i = 0; i < pairIds.size(); ++i) {
+        if (sessions[i] > 0)
+            stats.append(statsAt(i));
+    }
+    return stats;
+}
+
+bool Analytics::pair(int pair_id, PairStats *stats)
+{
+    // single pair, if it has any counts
+    QMutexLocker locker(&mutex);
+    auto it = index.constFind(pair_id);
+    if (it == index.constEnd() || sessions[it.value()] <= 0)
+        return false;
+    *stats = statsAt(it.value());
+    return true;
+}
+
+QHash<int, double> Analytics::slopes()
+{
+    // slope of all pairs with counts, under a single lock
+    QMutexLocker locker(&mutex);
+    QHash<int, double> slopes;
+    slopes.reserve(pairIds.size());
+    for (int i = 0; i < pairIds.size(); ++i) {
+        if (sessions[i] > 0)
+            slopes.insert(pairIds[i], statsAt(i).slope);
+    }
+    return slopes;
+}
+
+int Analytics::column(int pair_id)
+{
+    // existing column?
+    auto it = index.constFind(pair_id);
+    if (it != index.constEnd())
+        return it.value();
+
+    // add new one
+    int i = pairIds.size();
+    index.insert(pair_id, i);
+    pairIds.append(pair_id);
+    sessions.append(0);
+    minCount.append(std::numeric_limits<int>::max());
+    maxCount.append(std::numeric_limits<int>::min());
+    for (auto col : {&sumX, &sumY, &sumXX, &sumXY})
+        col->append(0.);
+    lastTime.append(0);
+    return i;
+}
+
+Analytics::Sums Analytics::fetchSums(int pair_id, qint64 origin)
+{
+    // aggregate counts of pair, served from the (chords_id, time, id, count) index
+    Statement query("SELECT COUNT(*), MIN(count), MAX(count), MAX(time), SUM(x), SUM(count), SUM(x*x), SUM(x*count) "
+                    "FROM (SELECT (time-:origin)/86400000.0 AS x, time, count FROM chordcount WHERE chords_id=:id)");
+    query->bindValue(":origin", origin);
+    query->bindValue(":id", pair_id);
+    if (query->exec() && query->first() && query->value(0).toInt() > 0)
+        return Sums{query->value(0).toInt(), query->value(1).toInt(), query->value(2).toInt(),
+                    query->value(4).toDouble(), query->value(5).toDouble(), query->value(6).toDouble(),
+                    query->value(7).toDouble(), query->value(3).toLongLong()};
+    return Sums{0, std::numeric_limits<int>::max(), std::numeric_limits<int>::min(), 0., 0., 0., 0., 0};
+}
+
+PairStats Analytics::statsAt(int i)
+{
+    // least squares slope from sums, zero if all sessions happened at the same time
+    double n = sessions[i];
+    double variance = n * sumXX[i] - sumX[i] * sumX[i];
+    double slope = n > 1 && variance > 1e-12 ? (n * sumXY[i] - sumX[i] * sumY[i]) / variance : 0.;
+    return PairStats{pairIds[i], sessions[i], minCount[i], maxCount[i], sumY[i] / n, slope, lastTime[i]};
+}
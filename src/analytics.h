@@ -0,0 +1,57 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QVector>
+#include "models.h"
+
+
+class PairStats
+{
+public:
+    int pair_id, sessions, min, max;
+    double mean, slope;     // slope is in changes per day
+    qint64 last_time;
+};
+
+class Analytics
+{
+public:
+    static void load();
+    static bool isLoaded();
+
+    static void countAdded(const ChordCount &count);
+    static void countRemoved(const ChordCount &count);
+
+    static QList<PairStats> pairs();
+    static bool pair(int pair_id, PairStats *stats);
+    static QHash<int, double> slopes();
+
+private:
+    static int column(int pair_id);
+    // all aggregates of a pair, fetched from the database before taking the lock
+    struct Sums
+    {
+        int sessions, min, max;
+        double sumX, sumY, sumXX, sumXY;
+        qint64 last_time;
+    };
+    static Sums fetchSums(int pair_id, qint64 origin);
+    static PairStats statsAt(int i);
+
+    static QMutex mutex;
+    static bool loaded;
+
+    // reference time for regression, so that sums of x stay small
+    static qint64 origin;
+
+    // aggregates per pair in columns, index by pair id
+    static QHash<int, int> index;
+    static QVector<int> pairIds, sessions, minCount, maxCount;
+    static QVector<double> sumX, sumY, sumXX, sumXY;
+    static QVector<qint64> lastTime;
+};
+
+#endif // ANALYTICS_H
@@ -0,0 +1,245 @@
+#include "analyticsmodel.h"
+
+#include <QDateTime>
+#include <cmath>
+
+PairStatsModel::PairStatsModel(QObject *parent) : QAbstractTableModel(parent)
+{
+
+}
+
+int PairStatsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int PairStatsModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 7;
+}
+
+QVariant PairStatsModel::data(const QModelIndex &index, int role) const
+{
+    // numeric values, so that columns sort by value
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return QVariant();
+    const auto &row = rows[index.row()];
+    switch (index.column()) {
+    case 0:
+        return row.name;
+    case 1:
+        return row.stats.sessions;
+    case 2:
+        return row.stats.min;
+    case 3:
+        return row.stats.max;
+    case 4:
+        return std::round(row.stats.mean * 10.) / 10.;
+    case 5:
+        return std::round(row.stats.slope * 100.) / 100.;
+    case 6:
+        return QDateTime::fromMSecsSinceEpoch(row.stats.last_time);
+    default:
+        return QVariant();
+    }
+}
+
+QVariant PairStatsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    static const QStringList headers = {"Pair", "Sessions", "Min", "Max", "Mean", "Trend/day", "Last practised"};
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+        return QVariant();
+    return headers.value(section);
+}
+
+void PairStatsModel::reload()
+{
+    // all pairs, skipping those of removed chords
+    beginResetModel();
+    rows.clear();
+    foreach (auto stats, Analytics::pairs()) {
+        QString name;
+        if (resolve(stats.pair_id, &name))
+            rows.append(Row{stats, name});
+    }
+    reindex();
+    endResetModel();
+}
+
+void PairStatsModel::updatePair(int pair_id)
+{
+    // current stats, if pair still has counts
+    PairStats stats;
+    bool hasStats = Analytics::pair(pair_id, &stats);
+
+    // known pair?
+    auto it = rowIndex.constFind(pair_id);
+    if (it != rowIndex.constEnd()) {
+        int row = it.value();
+        if (hasStats) {
+            rows[row].stats = stats;
+            emit dataChanged(index(row, 1), index(row, columnCount() - 1));
+        }
+        else {
+            // last count has been removed, rows behind it move up
+            beginRemoveRows(QModelIndex(), row, row);
+            rows.removeAt(row);
+            reindex();
+            endRemoveRows();
+        }
+        return;
+    }
+
+    // new pair
+    QString name;
+    if (hasStats && resolve(pair_id, &name)) {
+        beginInsertRows(QModelIndex(), rows.size(), rows.size());
+        rowIndex.insert(pair_id, rows.size());
+        rows.append(Row{stats, name});
+        endInsertRows();
+    }
+}
+
+bool PairStatsModel::resolve(int pair_id, QString *name)
+{
+    // name of pair, if both chords still exist
+    auto pair = ChordPair::getById(pair_id);
+    auto chord1 = pair.chord1(), chord2 = pair.chord2();
+    if (chord1.id < 0 || chord2.id < 0)
+        return false;
+    *name = QString("%1 <-> %2").arg(chord1.name).arg(chord2.name);
+    return true;
+}
+
+void PairStatsModel::reindex()
+{
+    rowIndex.clear();
+    for (int i = 0; i < rows.size(); ++i)
+        rowIndex.insert(rows[i].stats.pair_id, i);
+}
+
+ChordStatsModel::ChordStatsModel(QObject *parent) : QAbstractTableModel(parent)
+{
+
+}
+
+int ChordStatsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int ChordStatsModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 3;
+}
+
+QVariant ChordStatsModel::data(const QModelIndex &index, int role) const
+{
+    // numeric values, so that columns sort by value
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return QVariant();
+    const auto &row = rows[index.row()];
+    switch (index.column()) {
+    case 0:
+        return row.name;
+    case 1:
+        return row.sessions;
+    case 2:
+        return std::round(row.sum / row.sessions * 10.) / 10.;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant ChordStatsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    static const QStringList headers = {"Chord", "Sessions", "Mean"};
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+        return QVariant();
+    return headers.value(section);
+}
+
+void ChordStatsModel::reload()
+{
+    // sum up sessions and counts of all pairs for each chord
+    beginResetModel();
+    rows.clear();
+    rowIndex.clear();
+    pairs.clear();
+    foreach (auto stats, Analytics::pairs()) {
+        Contribution c;
+        if (!contribution(stats, &c))
+            continue;
+        pairs.insert(stats.pair_id, c);
+        foreach (auto chord_id, QList<int>({c.chord1_id, c.chord2_id})) {
+            auto it = rowIndex.constFind(chord_id);
+            if (it == rowIndex.constEnd()) {
+                rowIndex.insert(chord_id, rows.size());
+                rows.append(Row{chord_id, c.sessions, c.sum, Chord::getById(chord_id).name});
+            }
+            else {
+                rows[it.value()].sessions += c.sessions;
+                rows[it.value()].sum += c.sum;
+            }
+        }
+    }
+    endResetModel();
+}
+
+void ChordStatsModel::updatePair(int pair_id)
+{
+    // what pair added before and what it adds now, if it still has counts
+    Contribution before{-1, -1, 0, 0.}, after{-1, -1, 0, 0.};
+    if (pairs.contains(pair_id))
+        before = pairs.take(pair_id);
+    PairStats stats;
+    if (Analytics::pair(pair_id, &stats) && contribution(stats, &after))
+        pairs.insert(pair_id, after);
+
+    // apply difference to both chords, which never change for a pair
+    const auto &c = before.chord1_id >= 0 ? before : after;
+    if (c.chord1_id < 0)
+        return;
+    add(c.chord1_id, after.sessions - before.sessions, after.sum - before.sum);
+    add(c.chord2_id, after.sessions - before.sessions, after.sum - before.sum);
+}
+
+bool ChordStatsModel::contribution(const PairStats &stats, Contribution *c)
+{
+    // only pairs whose chords both still exist
+    auto pair = ChordPair::getById(stats.pair_id);
+    if (pair.chord1().id < 0 || pair.chord2().id < 0)
+        return false;
+    *c = Contribution{pair.chord1_id, pair.chord2_id, stats.sessions, stats.mean * stats.sessions};
+    return true;
+}
+
+void ChordStatsModel::add(int chord_id, int sessions, double sum)
+{
+    // new chord?
+    auto it = rowIndex.constFind(chord_id);
+    if (it == rowIndex.constEnd()) {
+        if (sessions > 0) {
+            beginInsertRows(QModelIndex(), rows.size(), rows.size());
+            rowIndex.insert(chord_id, rows.size());
+            rows.append(Row{chord_id, sessions, sum, Chord::getById(chord_id).name});
+            endInsertRows();
+        }
+        return;
+    }
+
+    // update, or remove chord without any sessions left
+    int row = it.value();
+    rows[row].sessions += sessions;
+    rows[row].sum += sum;
+    if (rows[row].sessions > 0) {
+        emit dataChanged(index(row, 1), index(row, columnCount() - 1));
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    rows.removeAt(row);
+    rowIndex.clear();
+    for (int i = 0; i < rows.size(); ++i)
+        rowIndex.insert(rows[i].chord_id, i);
+    endRemoveRows();
+}
@@ -0,0 +1,81 @@
+#ifndef ANALYTICSMODEL_H
+#define ANALYTICSMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QList>
+#include "analytics.h"
+
+
+class PairStatsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    PairStatsModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void reload();
+    void updatePair(int pair_id);
+
+private:
+    struct Row
+    {
+        PairStats stats;
+        QString name;
+    };
+
+    static bool resolve(int pair_id, QString *name);
+    void reindex();
+
+    QList<Row> rows;
+
+    // row by pair id
+    QHash<int, int> rowIndex;
+};
+
+class ChordStatsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    ChordStatsModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void reload();
+    void updatePair(int pair_id);
+
+private:
+    struct Row
+    {
+        int chord_id, sessions;
+        double sum;
+        QString name;
+    };
+
+    // what a pair adds to its chords, so that it can be taken back when the pair changes
+    struct Contribution
+    {
+        int chord1_id, chord2_id, sessions;
+        double sum;
+    };
+
+    static bool contribution(const PairStats &stats, Contribution *c);
+    void add(int chord_id, int sessions, double sum);
+
+    QList<Row> rows;
+
+    // row by chord id, and contribution by pair id
+    QHash<int, int> rowIndex;
+    QHash<int, Contribution> pairs;
+};
+
+#endif // ANALYTICSMODEL_H
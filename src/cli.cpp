@@ -0,0 +1,256 @@
+#include "cli.h"
+#include "clicktrack.h"
+#include "database.h"
+
+#include <QFile>
+#include <QSqlDatabase>
+#include <QTextStream>
+#include <algorithm>
+#include <limits>
+
+// number of counts shown for a single pair by default
+static const int LATEST_DEFAULT = 10;
+
+static const QStringList COMMANDS = {"help", "chords", "pairs", "add", "latest", "export", "render-clicks"};
+
+bool Cli::isCommand(const QString &command)
+{
+    return COMMANDS.contains(command);
+}
+
+int Cli::run(const QStringList &arguments)
+{
+    // first argument is the program
+    QString command = arguments.value(1);
+    QStringList args = arguments.mid(2);
+    if (command == "help")
+        return usage(true);
+
+    // missing or unknown command, before the database is created
+    if (!isCommand(command))
+        return usage(false);
+
+    // commands that don't need the database
+    if (command == "render-clicks")
+        return renderClicks(args);
+
+    // open database
+    QString error = Database::openDefault();
+    if (!error.isEmpty()) {
+        QTextStream(stderr) << error << "\n";
+        return 1;
+    }
+
+    // run command
+    int result;
+    if (command == "chords")
+        result = chords();
+    else if (command == "pairs")
+        result = pairs();
+    else if (command == "add")
+        result = add(args);
+    else if (command == "latest")
+        result = latest(args);
+    else if (command == "export")
+        result = exportCounts(args);
+    else
+        result = usage(false);
+
+    // clean up prepared statements
+    Database::clearStatements(QSqlDatabase::database().connectionName());
+    return result;
+}
+
+int Cli::usage(bool requested)
+{
+    // asked for help is a success, anything else an error
+    QTextStream out(requested ? stdout : stderr);
+    out << "Usage: omc <command> [arguments]\n"
+           "\n"
+           "Commands:\n"
+           "  chords                           list all chords\n"
+           "  pairs                            list practised pairs with their number of sessions\n"
+           "  add <chord1> <chord2> <count>    record a count for a pair\n"
+           "  latest [<chord1> <chord2> [n]]   latest count of all pairs, or last n counts of one\n"
+           "  export [file]                    write all counts as CSV to file or stdout\n"
+           "  render-clicks <file> [bpm]       write countdown and metronome of a session as WAV\n"
+           "  help                             show this help\n";
+    return requested ? 0 : 2;
+}
+
+int Cli::chords()
+{
+    // one name per line
+    QTextStream out(stdout);
+    foreach (auto chord, Chord::list()) {
+        out << chord.name << "\n";
+    }
+    return 0;
+}
+
+int Cli::pairs()
+{
+    // stored pairs by name
+    QList<ChordPair> list = ChordPair::matrix().values();
+    QList<QPair<QString, int>> rows;
+    foreach (auto pair, list) {
+        rows.append(qMakePair(pairName(pair), pair.sessions));
+    }
+    std::sort(rows.begin(), rows.end());
+
+    // print them
+    QTextStream out(stdout);
+    foreach (auto row, rows) {
+        out << row.first << "\t" << row.second << "\n";
+    }
+    return 0;
+}
+
+int Cli::add(const QStringList &args)
+{
+    // parse
+    bool ok;
+    int count = args.value(2).toInt(&ok);
+    if (args.length() != 3 || !ok || count < 0)
+        return usage(false);
+
+    // get pair
+    ChordPair pair = ChordPair::empty();
+    if (!findPair(args[0], args[1], &pair))
+        return 1;
+
+    // store pair if this is its first count, then add it
+    Transaction transaction;
+    auto stored = ChordPair::getOrCreate(pair.chord1_id, pair.chord2_id);
+    if (!stored.exists())
+        return 1;
+    auto created = ChordCount::create(stored.id, count);
+    if (!created.exists() || !transaction.commit()) {
+        QTextStream(stderr) << "Could not store count.\n";
+        return 1;
+    }
+
+    // confirm
+    QTextStream(stdout) << pairName(stored) << "\t" << created.count << "\t"
+                        << created.dateTime().toString(Qt::ISODate) << "\n";
+    return 0;
+}
+
+int Cli::latest(const QStringList &args)
+{
+    QTextStream out(stdout);
+
+    // all pairs, most recently practised first
+    if (args.isEmpty()) {
+        QList<ChordPair> list = ChordPair::matrix().values();
+        std::sort(list.begin(), list.end(), [](const ChordPair &a, const ChordPair &b) {
+            return a.latest_time > b.latest_time;
+        });
+        foreach (auto pair, list) {
+            if (pair.latest_count < 0)
+                continue;
+            out << pairName(pair) << "\t" << pair.latest_count << "\t"
+                << QDateTime::fromMSecsSinceEpoch(pair.latest_time).toString(Qt::ISODate) << "\n";
+        }
+        return 0;
+    }
+
+    // parse
+    bool ok = true;
+    int n = args.length() > 2 ? args[2].toInt(&ok) : LATEST_DEFAULT;
+    if (args.length() < 2 || args.length() > 3 || !ok || n <= 0)
+        return usage(false);
+
+    // last counts of single pair, newest first
+    ChordPair pair = ChordPair::empty();
+    if (!findPair(args[0], args[1], &pair))
+        return 1;
+    if (!pair.exists())
+        return 0;
+    foreach (auto count, ChordCount::pageForPair(pair.id, std::numeric_limits<qint64>::max(),
+                                                         std::numeric_limits<int>::max(), n)) {
+        out << count.dateTime().toString(Qt::ISODate) << "\t" << count.count << "\n";
+    }
+    return 0;
+}
+
+int Cli::exportCounts(const QStringList &args)
+{
+    // write to file or stdout
+    if (args.length() > 1)
+        return usage(false);
+    QFile file;
+    bool opened;
+    if (args.isEmpty()) {
+        opened = file.open(stdout, QIODevice::WriteOnly);
+    }
+    else {
+        file.setFileName(args[0]);
+        opened = file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    if (!opened) {
+        QTextStream(stderr) << "Could not open " << args.value(0) << " for writing.\n";
+        return 1;
+    }
+    QTextStream out(&file);
+
+    // quote names, which may contain commas
+    auto quote = [](QString name) { return "\"" + name.replace("\"", "\"\"") + "\""; };
+
+    // header and one line per count, grouped by pair
+    out << "chord1,chord2,time,count\n";
+    foreach (auto pair, ChordPair::matrix().values()) {
+        QString names = quote(pair.chord1().name) + "," + quote(pair.chord2().name) + ",";
+        foreach (auto count, ChordCount::listForPair(pair.id)) {
+            out << names << count.dateTime().toUTC().toString(Qt::ISODateWithMs) << "," << count.count << "\n";
+        }
+    }
+    return 0;
+}
+
+int Cli::renderClicks(const QStringList &args)
+{
+    // parse
+    bool ok = true;
+    double bpm = args.length() > 1 ? args[1].toDouble(&ok) : 60.;
+    if (args.isEmpty() || args.length() > 2 || !ok || bpm < 0)
+        return usage(false);
+
+    // render whole session offline
+    if (!ClickTrack::renderWav(args[0], bpm)) {
+        QTextStream(stderr) << "Could not write " << args[0] << ".\n";
+        return 1;
+    }
+    return 0;
+}
+
+bool Cli::findPair(const QString &name1, const QString &name2, ChordPair *pair)
+{
+    // find chords by name
+    int id1 = -1, id2 = -1;
+    foreach (auto chord, Chord::list()) {
+        if (chord.name == name1)
+            id1 = chord.id;
+        if (chord.name == name2)
+            id2 = chord.id;
+    }
+    foreach (auto name, QStringList({id1 < 0 ? name1 : QString(), id2 < 0 ? name2 : QString()})) {
+        if (!name.isEmpty())
+            QTextStream(stderr) << "Unknown chord: " << name << "\n";
+    }
+    if (id1 < 0 || id2 < 0)
+        return false;
+    if (id1 == id2) {
+        QTextStream(stderr) << "Chords of a pair must differ.\n";
+        return false;
+    }
+
+    // pair with lower id first, which may not be stored yet
+    *pair = ChordPair::get(std::min(id1, id2), std::max(id1, id2));
+    return true;
+}
+
+QString Cli::pairName(ChordPair pair)
+{
+    return QString("%1 <-> %2").arg(pair.chord1().name).arg(pair.chord2().name);
+}
@@ -0,0 +1,28 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include <QStringList>
+#include "models.h"
+
+
+// headless access to the database, for scripts and cron jobs
+class Cli
+{
+public:
+    static bool isCommand(const QString &command);
+    static int run(const QStringList &arguments);
+
+private:
+    static int usage(bool requested);
+    static int chords();
+    static int pairs();
+    static int add(const QStringList &args);
+    static int latest(const QStringList &args);
+    static int exportCounts(const QStringList &args);
+    static int renderClicks(const QStringList &args);
+
+    static bool findPair(const QString &name1, const QString &name2, ChordPair *pair);
+    static QString pairName(ChordPair pair);
+};
+
+#endif // CLI_H
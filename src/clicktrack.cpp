@@ -0,0 +1,142 @@
+#include "clicktrack.h"
+#include "wavfile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// chunk size for offline rendering (~20 ms)
+static const int CHUNK_FRAMES = 960;
+
+static const double PI = 3.14159265358979323846;
+
+ClickTrack::ClickTrack(int sampleRate, double bpm, qint64 countdown, qint64 duration)
+    : rate(sampleRate), frames(duration * sampleRate / 1000)
+{
+    // pre-render sounds once
+    sounds[Countdown] = click(sampleRate, 1500., 0.04);
+    sounds[Go] = click(sampleRate, 2000., 0.12);
+    sounds[Beat] = click(sampleRate, 1000., 0.03);
+    longest = 0;
+    for (int i = 0; i < SoundCount; ++i)
+        longest = std::max(longest, int(sounds[i].size()));
+
+    // one countdown click per second, then "GO!"
+    for (qint64 ms = 0; ms < countdown; ms += 1000) {
+        onsets.append(ms * sampleRate / 1000);
+        kinds.append(Countdown);
+    }
+    qint64 go = countdown * sampleRate / 1000;
+    onsets.append(go);
+    kinds.append(Go);
+
+    // beats, each computed from its index, so rounding errors don't add up
+    if (bpm > 0) {
+        double interval = 60. * sampleRate / bpm;
+        for (qint64 k = 1; ; ++k) {
+            qint64 onset = go + std::llround(k * interval);
+            if (onset >= frames)
+                break;
+            onsets.append(onset);
+            kinds.append(Beat);
+        }
+    }
+}
+
+void ClickTrack::render(qint16 *out, qint64 start, int count) const
+{
+    // silence
+    std::memset(out, 0, count * sizeof(qint16));
+
+    // first click that may still be sounding at start
+    auto it = std::lower_bound(onsets.constBegin(), onsets.constEnd(), start - longest + 1);
+
+    // mix all clicks overlapping the requested range
+    for (int i = it - onsets.constBegin(); i < onsets.size() && onsets[i] < start + count; ++i) {
+        const auto &sound = sounds[kinds[i]];
+        qint64 from = std::max(start, onsets[i]), to = std::min(start + count, onsets[i] + sound.size());
+        for (qint64 pos = from; pos < to; ++pos) {
+            int sample = out[pos - start] + sound[pos - onsets[i]];
+            out[pos - start] = qint16(std::min(std::max(sample, -32768), 32767));
+        }
+    }
+}
+
+bool ClickTrack::renderWav(const QString &filename, double bpm, int sampleRate)
+{
+    // render whole session in chunks, through a ring just like the live output
+    ClickTrack track(sampleRate, bpm);
+    RingBuffer ring(RING_FRAMES);
+    QVector<qint16> samples(track.length()), chunk(CHUNK_FRAMES);
+    qint64 position = 0, written = 0;
+    while (written < track.length()) {
+        int count = int(std::min<qint64>(std::min<qint64>(ring.space(), CHUNK_FRAMES), track.length() - position));
+        track.render(chunk.data(), position, count);
+        position += ring.write(chunk.constData(), count);
+        written += ring.read(samples.data() + written, int(samples.size() - written));
+    }
+    return WavFile::write(filename, samples, sampleRate);
+}
+
+QVector<qint16> ClickTrack::click(int sampleRate, double frequency, double length)
+{
+    // exponentially decaying sine, tapered to zero, so that the end of a click isn't a click itself
+    int n = int(length * sampleRate);
+    QVector<qint16> sound(n);
+    for (int i = 0; i < n; ++i) {
+        double t = double(i) / sampleRate;
+        double envelope = std::exp(-t / (length / 5.)) * (1. - double(i) / n);
+        sound[i] = qint16(20000. * envelope * std::sin(2. * PI * frequency * t));
+    }
+    return sound;
+}
+
+RingBuffer::RingBuffer(int capacity)
+    : head(0), tail(0)
+{
+    // round capacity up to power of two, so that positions wrap with a mask
+    int size = 1;
+    while (size < capacity)
+        size <<= 1;
+    buffer.resize(size);
+    mask = size - 1;
+}
+
+int RingBuffer::write(const qint16 *data, int count)
+{
+    // only producer moves head
+    quint64 h = head.load(std::memory_order_relaxed), t = tail.load(std::memory_order_acquire);
+    count = int(std::min<quint64>(count, buffer.size() - (h - t)));
+    for (int i = 0; i < count; ++i)
+        buffer[(h + i) & mask] = data[i];
+    head.store(h + count, std::memory_order_release);
+    return count;
+}
+
+int RingBuffer::read(qint16 *data, int count)
+{
+    // only consumer moves tail
+    quint64 t = tail.load(std::memory_order_relaxed), h = head.load(std::memory_order_acquire);
+    count = int(std::min<quint64>(count, h - t));
+    for (int i = 0; i < count; ++i)
+        data[i] = buffer[(t + i) & mask];
+    tail.store(t + count, std::memory_order_release);
+    return count;
+}
+
+int RingBuffer::available() const
+{
+    return int(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+}
+
+int RingBuffer::space() const
+{
+    return int(buffer.size()) - available();
+}
+
+void RingBuffer::clear()
+{
+    // only while neither side is running
+    head.store(0);
+    tail.store(0);
+}
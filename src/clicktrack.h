@@ -0,0 +1,60 @@
+#ifndef CLICKTRACK_H
+#define CLICKTRACK_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+
+// countdown, "GO!" and beat clicks of a session at exact sample positions
+class ClickTrack
+{
+public:
+    static const int SAMPLE_RATE = 48000;
+
+    // ring size in frames (~170 ms at 48 kHz), shared by live output and offline rendering
+    static const int RING_FRAMES = 8192;
+
+    ClickTrack(int sampleRate, double bpm, qint64 countdown = 3000, qint64 duration = 60000);
+
+    int sampleRate() const { return rate; }
+    qint64 length() const { return frames; }
+    void render(qint16 *out, qint64 start, int count) const;
+
+    static bool renderWav(const QString &filename, double bpm, int sampleRate = SAMPLE_RATE);
+
+private:
+    enum Sound { Countdown, Go, Beat, SoundCount };
+    static QVector<qint16> click(int sampleRate, double frequency, double length);
+
+    int rate;
+    qint64 frames;
+
+    // sorted sample positions of clicks, with their sounds
+    QVector<qint64> onsets;
+    QVector<int> kinds;
+
+    // pre-rendered click sounds, and length of the longest one
+    QVector<qint16> sounds[SoundCount];
+    int longest;
+};
+
+// lock-free sample buffer between a single producer and a single consumer thread
+class RingBuffer
+{
+public:
+    explicit RingBuffer(int capacity);
+
+    int write(const qint16 *data, int count);
+    int read(qint16 *data, int count);
+    int available() const;
+    int space() const;
+    void clear();
+
+private:
+    QVector<qint16> buffer;
+    quint64 mask;
+    std::atomic<quint64> head, tail;
+};
+
+#endif // CLICKTRACK_H
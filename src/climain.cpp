@@ -0,0 +1,11 @@
+#include "cli.h"
+
+#include <QCoreApplication>
+
+
+int main(int argc, char *argv[])
+{
+    // same commands as "omc <command>", but without loading any GUI libraries
+    QCoreApplication app(argc, argv);
+    return Cli::run(app.arguments());
+}
@@ -0,0 +1,117 @@
+#include "colorscale.h"
+
+#include <QStringList>
+
+ColorScale::ColorScale()
+    : stops({20, 40, 60}),
+      colors({QColor::fromRgb(100, 41, 38), QColor::fromRgb(100, 70, 28),
+              QColor::fromRgb(99, 99, 59), QColor::fromRgb(47, 87, 47)}),
+      continuous(false)
+{
+    build();
+}
+
+void ColorScale::load(QSettings &settings)
+{
+    // thresholds, must be increasing
+    QList<int> newStops;
+    foreach (auto value, settings.value("matrix/thresholds").toStringList()) {
+        bool ok;
+        int stop = value.toInt(&ok);
+        if (ok && (newStops.isEmpty() || stop > newStops.last()))
+            newStops.append(stop);
+    }
+
+    // colours, one more than thresholds
+    QList<QColor> newColors;
+    foreach (auto value, settings.value("matrix/colors").toStringList()) {
+        QColor color(value);
+        if (color.isValid())
+            newColors.append(color);
+    }
+
+    // only use complete sets, keep defaults otherwise
+    if (!newStops.isEmpty() && newColors.length() == newStops.length() + 1) {
+        stops = newStops;
+        colors = newColors;
+    }
+    continuous = settings.value("matrix/continuous", continuous).toBool();
+    build();
+}
+
+void ColorScale::save(QSettings &settings) const
+{
+    // store as lists of strings, so that they can be edited in the file
+    QStringList values;
+    foreach (auto stop, stops) {
+        values.append(QString::number(stop));
+    }
+    settings.setValue("matrix/thresholds", values);
+    values.clear();
+    foreach (auto color, colors) {
+        values.append(color.name());
+    }
+    settings.setValue("matrix/colors", values);
+    settings.setValue("matrix/continuous", continuous);
+}
+
+void ColorScale::setThresholds(const QList<int> &thresholds)
+{
+    // need increasing thresholds
+    if (thresholds.isEmpty())
+        return;
+    for (int i = 1; i < thresholds.length(); ++i) {
+        if (thresholds[i] <= thresholds[i - 1])
+            return;
+    }
+
+    // different number of bands? then spread current colours evenly over the new ones
+    if (thresholds.length() != stops.length()) {
+        QList<QColor> newColors;
+        int n = thresholds.length() + 1, m = colors.length();
+        for (int k = 0; k < n; ++k) {
+            double pos = double(k) / (n - 1) * (m - 1);
+            int i = std::min(int(pos), m - 2);
+            newColors.append(mix(colors[i], colors[i + 1], pos - i));
+        }
+        colors = newColors;
+    }
+    stops = thresholds;
+    build();
+}
+
+void ColorScale::setContinuous(bool continuous)
+{
+    this->continuous = continuous;
+    build();
+}
+
+void ColorScale::build()
+{
+    // colour for every count, so that shading a cell is just a lookup
+    table.resize(MAX_COUNT + 1);
+    int band = 0;
+    for (int count = 0; count <= MAX_COUNT; ++count) {
+        // find band, i.e. number of thresholds below count
+        while (band < stops.length() && count > stops[band])
+            band++;
+
+        // solid band, or blend between colours placed at the thresholds below and above
+        if (!continuous || band == stops.length()) {
+            table[count] = colors[band];
+        }
+        else {
+            int lower = band > 0 ? stops[band - 1] : 0, upper = stops[band];
+            double t = upper > lower ? double(count - lower) / (upper - lower) : 1.;
+            table[count] = mix(colors[band], colors[band + 1], t);
+        }
+    }
+}
+
+QColor ColorScale::mix(const QColor &a, const QColor &b, double t)
+{
+    // linear interpolation in RGB
+    return QColor::fromRgbF(a.redF() + (b.redF() - a.redF()) * t,
+                            a.greenF() + (b.greenF() - a.greenF()) * t,
+                            a.blueF() + (b.blueF() - a.blueF()) * t);
+}
@@ -0,0 +1,44 @@
+#ifndef COLORSCALE_H
+#define COLORSCALE_H
+
+#include <QColor>
+#include <QList>
+#include <QSettings>
+#include <QVariant>
+#include <QVector>
+#include <algorithm>
+
+
+class ColorScale
+{
+public:
+    // highest count with an entry of its own, everything above gets its colour
+    static const int MAX_COUNT = 1000;
+
+    ColorScale();
+
+    void load(QSettings &settings);
+    void save(QSettings &settings) const;
+
+    QList<int> thresholds() const { return stops; }
+    void setThresholds(const QList<int> &thresholds);
+    bool isContinuous() const { return continuous; }
+    void setContinuous(bool continuous);
+
+    // precomputed colour for a count
+    inline const QVariant &color(int count) const { return table[std::min(std::max(count, 0), MAX_COUNT)]; }
+
+private:
+    void build();
+    static QColor mix(const QColor &a, const QColor &b, double t);
+
+    // counts above stops[k] get colors[k+1], with a gradient colors[k] sits at stops[k-1]
+    QList<int> stops;
+    QList<QColor> colors;
+    bool continuous;
+
+    // colour for every count from 0 to MAX_COUNT
+    QVector<QVariant> table;
+};
+
+#endif // COLORSCALE_H
@@ -0,0 +1,206 @@
+#include "database.h"
+#include "schema.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+
+QString Database::filename;
+QHash<QString, QHash<QString, QSqlQuery*>> Database::statements;
+QMutex Database::mutex;
+thread_local int Transaction::depth = 0;
+thread_local bool Transaction::failed = false;
+thread_local QList<std::function<void()>> Transaction::pending;
+
+QString Database::openDefault()
+{
+    // get or create config directory
+    QDir dir = QDir::home();
+    if (!dir.exists(".oneminutechanges") && !dir.mkdir(".oneminutechanges"))
+        return "Could not create config directory.";
+    if (!dir.cd(".oneminutechanges"))
+        return "Could not enter config directory.";
+
+    // check database
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE"))
+        return "No sqlite driver available.";
+
+    // create and open database
+    if (!open(dir.absoluteFilePath("database.sqlite")))
+        return "Could not open database.";
+    QSqlDatabase db = QSqlDatabase::database();
+
+    // set journal mode and caching
+    if (!configure(db))
+        qWarning() << "Could not configure database.";
+
+    // create or update tables
+    if (!Schema::migrate(db))
+        return "Could not update database schema.";
+    return QString();
+}
+
+bool Database::open(const QString &filename)
+{
+    // create default connection for main thread
+    Database::filename = filename;
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+    db.setDatabaseName(filename);
+    return db.open();
+}
+
+bool Database::configure(QSqlDatabase &db)
+{
+    // write ahead log with relaxed syncing, which is still safe against corruption in WAL mode,
+    // plus a 16MB page cache and in-memory temp tables
+    QSqlQuery query(db);
+    return query.exec("PRAGMA journal_mode=WAL;")
+        && query.exec("PRAGMA synchronous=NORMAL;")
+        && query.exec("PRAGMA cache_size=-16000;")
+        && query.exec("PRAGMA temp_store=MEMORY;")
+        && query.exec("PRAGMA busy_timeout=5000;");
+}
+
+QSqlDatabase Database::connection()
+{
+    // main thread uses the default connection
+    if (QThread::currentThread() == QCoreApplication::instance()->thread())
+        return QSqlDatabase::database();
+
+    // other threads use their own connection to the same file
+    QString name = QString("omc-%1").arg(quintptr(QThread::currentThreadId()));
+    if (QSqlDatabase::contains(name))
+        return QSqlDatabase::database(name);
+
+    // open it
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+    db.setDatabaseName(filename);
+    if (!db.open() || !configure(db))
+        qWarning() << "Could not open database connection" << name << ":" << db.lastError().text();
+    return db;
+}
+
+void Database::closeConnection()
+{
+    // get name of connection for this thread
+    QString name;
+    {
+        QSqlDatabase db = connection();
+        name = db.connectionName();
+    }
+
+    // statements first, then connection, which must not be in use anymore
+    clearStatements(name);
+    QSqlDatabase::removeDatabase(name);
+}
+
+QSqlQuery &Database::prepared(const QString &sql)
+{
+    // get statements for connection of this thread
+    QSqlDatabase db = connection();
+    QMutexLocker locker(&mutex);
+    auto &pool = statements[db.connectionName()];
+
+    // prepare statement only once
+    auto it = pool.find(sql);
+    if (it == pool.end()) {
+        auto query = new QSqlQuery(db);
+        if (!query->prepare(sql))
+            qWarning() << "Could not prepare statement:" << query->lastError().text();
+        it = pool.insert(sql, query);
+    }
+    return *it.value();
+}
+
+void Database::clearStatements(const QString &connectionName)
+{
+    // delete all statements, must happen before connection is closed
+    QMutexLocker locker(&mutex);
+    qDeleteAll(statements.take(connectionName));
+}
+
+Statement::Statement(const QString &sql) : query(Database::prepared(sql))
+{
+
+}
+
+Statement::~Statement()
+{
+    // reset statement, so that it doesn't keep a read transaction open
+    query.finish();
+}
+
+Transaction::Transaction() : outermost(depth == 0), finished(false)
+{
+    // begin on outermost scope only
+    if (outermost) {
+        failed = !Database::connection().transaction();
+        if (failed)
+            qWarning() << "Could not start transaction:" << Database::connection().lastError().text();
+    }
+    depth++;
+}
+
+Transaction::~Transaction()
+{
+    // never committed, so roll back
+    if (!finished)
+        rollback();
+    depth--;
+}
+
+bool Transaction::commit()
+{
+    // already done?
+    if (finished)
+        return false;
+    finished = true;
+
+    // nested scopes only commit together with the outermost one
+    if (!outermost)
+        return !failed;
+
+    // rollback if any nested scope failed
+    if (failed || !Database::connection().commit()) {
+        Database::connection().rollback();
+        pending.clear();
+        return false;
+    }
+
+    // now the changes are visible to everyone
+    auto functions = pending;
+    pending.clear();
+    foreach (auto function, functions) {
+        function();
+    }
+    return true;
+}
+
+void Transaction::rollback()
+{
+    // already done?
+    if (finished)
+        return;
+    finished = true;
+
+    // for nested scopes, just mark the whole transaction as failed
+    if (outermost) {
+        Database::connection().rollback();
+        pending.clear();
+    }
+    else {
+        failed = true;
+    }
+}
+
+void Transaction::afterCommit(const std::function<void()> &function)
+{
+    // without transaction, changes are committed already
+    if (depth == 0)
+        function();
+    else
+        pending.append(function);
+}
@@ -0,0 +1,70 @@
+#ifndef DATABASE_H
+#define DATABASE_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <functional>
+
+
+class Database
+{
+public:
+    static QString openDefault();
+    static bool open(const QString &filename);
+    static bool configure(QSqlDatabase &db);
+    static QSqlDatabase connection();
+    static void closeConnection();
+
+    static QSqlQuery &prepared(const QString &sql);
+    static void clearStatements(const QString &connectionName);
+
+private:
+    // database file, used for opening connections in other threads
+    static QString filename;
+
+    // prepared statements per connection name and sql
+    static QHash<QString, QHash<QString, QSqlQuery*>> statements;
+    static QMutex mutex;
+};
+
+class Statement
+{
+public:
+    explicit Statement(const QString &sql);
+    ~Statement();
+
+    inline QSqlQuery *operator->() { return &query; }
+    inline QSqlQuery &operator*() { return query; }
+
+private:
+    QSqlQuery &query;
+};
+
+class Transaction
+{
+public:
+    Transaction();
+    ~Transaction();
+
+    bool commit();
+    void rollback();
+
+    static void afterCommit(const std::function<void()> &function);
+
+private:
+    // only the outermost scope talks to the database, nested ones join it
+    bool outermost, finished;
+
+    // transactions are per connection, and each thread has its own
+    static thread_local int depth;
+    static thread_local bool failed;
+
+    // functions to run once the outermost scope has committed
+    static thread_local QList<std::function<void()>> pending;
+};
+
+#endif // DATABASE_H
@@ -0,0 +1,130 @@
+#include "historymodel.h"
+
+#include <QFutureWatcher>
+#include <limits>
+#include "worker.h"
+
+HistoryModel::HistoryModel(QObject *parent)
+    : QAbstractTableModel(parent), pair_id(-1), chord1_id(-1), chord2_id(-1), loading(false), atEnd(true), generation(0)
+{
+
+}
+
+int HistoryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : counts.size();
+}
+
+int HistoryModel::columnCount(const QModelIndex &parent) const
+{
+    // time and count
+    return parent.isValid() ? 0 : 2;
+}
+
+QVariant HistoryModel::data(const QModelIndex &index, int role) const
+{
+    // valid?
+    if (!index.isValid() || index.row() >= counts.size())
+        return QVariant();
+    const auto &count = counts[index.row()];
+
+    switch (role) {
+    case Qt::DisplayRole:
+        // only convert time for rows that are actually shown
+        return index.column() == 0 ? QVariant(count.dateTime().toString()) : QVariant(count.count);
+    case Qt::UserRole:
+        return count.id;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant HistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    // only horizontal header
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+        return QVariant();
+    return section == 0 ? QString("Time") : QString("Count");
+}
+
+bool HistoryModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !atEnd && !loading;
+}
+
+void HistoryModel::fetchMore(const QModelIndex &parent)
+{
+    // anything to fetch?
+    if (!canFetchMore(parent))
+        return;
+    loading = true;
+
+    // continue after oldest loaded count
+    qint64 before_time = std::numeric_limits<qint64>::max();
+    int before_id = std::numeric_limits<int>::max();
+    if (!counts.isEmpty()) {
+        before_time = counts.last().time;
+        before_id = counts.last().id;
+    }
+
+    // load page in background
+    int id = pair_id, request = generation;
+    auto watcher = new QFutureWatcher<QList<ChordCount>>(this);
+    connect(watcher, &QFutureWatcher<QList<ChordCount>>::finished, this, [this, watcher, request]() {
+        watcher->deleteLater();
+
+        // pair changed in the meantime?
+        if (request != generation)
+            return;
+        loading = false;
+
+        // append rows
+        auto page = watcher->result();
+        atEnd = page.length() < PAGE_SIZE;
+        if (!page.isEmpty()) {
+            beginInsertRows(QModelIndex(), counts.size(), counts.size() + page.length() - 1);
+            foreach (auto count, page) {
+                counts.append(count);
+            }
+            endInsertRows();
+        }
+    });
+    watcher->setFuture(Worker::run([id, before_time, before_id]() {
+        return ChordCount::pageForPair(id, before_time, before_id, PAGE_SIZE);
+    }));
+}
+
+void HistoryModel::setPair(const ChordPair &pair)
+{
+    // reset model, virtual pairs have no history
+    beginResetModel();
+    generation++;
+    pair_id = pair.id;
+    chord1_id = pair.chord1_id;
+    chord2_id = pair.chord2_id;
+    counts.clear();
+    loading = false;
+    atEnd = !pair.exists();
+    endResetModel();
+
+    // load first page
+    fetchMore(QModelIndex());
+}
+
+void HistoryModel::addCount(const ChordPair &pair, const ChordCount &count)
+{
+    // only for shown pair, which might just have been stored with its first count
+    if (pair.chord1_id != chord1_id || pair.chord2_id != chord2_id || !pair.exists() || count.chords_id != pair.id)
+        return;
+    pair_id = pair.id;
+
+    // new counts are the newest, so they go on top
+    beginInsertRows(QModelIndex(), 0, 0);
+    counts.prepend(count);
+    endInsertRows();
+}
+
+int HistoryModel::countId(int row) const
+{
+    return row >= 0 && row < counts.size() ? counts[row].id : -1;
+}
@@ -0,0 +1,43 @@
+#ifndef HISTORYMODEL_H
+#define HISTORYMODEL_H
+
+#include <QAbstractTableModel>
+#include <QList>
+#include "models.h"
+
+
+class HistoryModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    HistoryModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    void setPair(const ChordPair &pair);
+    void addCount(const ChordPair &pair, const ChordCount &count);
+    int countId(int row) const;
+
+private:
+    // number of rows loaded per page
+    static const int PAGE_SIZE = 100;
+
+    // shown pair, id is -1 while it's virtual
+    int pair_id, chord1_id, chord2_id;
+
+    // loaded counts, newest first
+    QList<ChordCount> counts;
+
+    // paging state, generation is increased on every reset to drop outdated pages
+    bool loading, atEnd;
+    int generation;
+};
+
+#endif // HISTORYMODEL_H
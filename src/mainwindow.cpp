@@ -1,25 +1,75 @@
+#include <QAction>
 #include <QDebug>
+#include <QDir>
+#include <QFileDialog>
+#include <QHeaderView>
 #include <QInputDialog>
 #include <QItemSelectionModel>
 #include <QMessageBox>
+#include <QSortFilterProxyModel>
 #include <algorithm>
-#include <cmath>
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
+#include "analytics.h"
+#include "database.h"
 #include "models.h"
+#include "onsets.h"
+#include "sampling.h"
+#include "stats.h"
+#include "wavfile.h"
+#include "worker.h"
 
 MainWindow::MainWindow(QSqlDatabase *db, QWidget *parent)
-    : QMainWindow(parent), ui(new Ui::MainWindow), db(db)
+    : QMainWindow(parent), ui(new Ui::MainWindow), timerNext(-1), db(db),
+      settings(QDir::home().absoluteFilePath(".oneminutechanges/settings.ini"), QSettings::IniFormat),
+      chordsRequest(0), plotNow(0)
 {
     ui->setupUi(this);
 
+    // matrix model with fixed cell sizes, so nothing needs to be measured
+    matrixModel = new ChordMatrixModel(this);
+    ui->tableChords->setModel(matrixModel);
+    ui->tableChords->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui->tableChords->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    setupColors();
+    setupMetronome();
+
+    // history model, which fetches rows page by page
+    historyModel = new HistoryModel(this);
+    ui->tableHistory->setModel(historyModel);
+    ui->tableHistory->horizontalHeader()->resizeSection(
+                0, ui->tableHistory->fontMetrics().horizontalAdvance(QDateTime::currentDateTime().toString()) + 12);
+
+    // plot
+    setupPlot();
+
+    // analytics models, sorted by the views through proxies
+    pairStatsModel = new PairStatsModel(this);
+    auto pairStatsProxy = new QSortFilterProxyModel(this);
+    pairStatsProxy->setSourceModel(pairStatsModel);
+    ui->tablePairStats->setModel(pairStatsProxy);
+    chordStatsModel = new ChordStatsModel(this);
+    auto chordStatsProxy = new QSortFilterProxyModel(this);
+    chordStatsProxy->setSourceModel(chordStatsModel);
+    ui->tableChordStats->setModel(chordStatsProxy);
+
     // signals/slots
     connect(ui->tableChords->selectionModel(), &QItemSelectionModel::currentChanged, this, &MainWindow::chordPair_selected);
+    connect(ui->tableChords->selectionModel(), &QItemSelectionModel::selectionChanged, &historyTimer, qOverload<>(&QTimer::start));
     connect(&timer, &QTimer::timeout, this, &MainWindow::timerUpdate);
+    connect(&historyTimer, &QTimer::timeout, this, &MainWindow::updateHistory);
+
+    // session timer only fires when the shown value changes, with millisecond accuracy
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+
+    // coalesce history reloads
+    historyTimer.setSingleShot(true);
+    historyTimer.setInterval(0);
 
     // initial update
-    updateChordList();
-    updateChordTable();
+    updateChords();
+    updateAnalytics();
 }
 
 MainWindow::~MainWindow()
@@ -32,150 +82,164 @@ void MainWindow::initDatabase()
 
 }
 
-void MainWindow::updateChordTable()
+void MainWindow::updateChords()
 {
-    // get all chords
-    auto chords = Chord::list();
-    QStringList chordNames;
-    foreach (auto chord, chords) {
-        chordNames.append(chord.name);
-    }
+    // load chords and matrix in background
+    int request = ++chordsRequest;
+    whenReady(Worker::run([]() { return qMakePair(Chord::list(), ChordPair::matrix()); }),
+              [this, request](const QPair<QList<Chord>, QHash<QPair<int, int>, ChordPair>> &result) {
+        // still the latest request?
+        if (request != chordsRequest)
+            return;
+
+        // show it
+        updateChordList(result.first);
+        updateChordTable(result.first, result.second);
+    });
+}
 
+void MainWindow::updateChordTable(const QList<Chord> &chords, const QHash<QPair<int, int>, ChordPair> &pairs)
+{
     // get current
     auto current = selectedPair();
-    auto currentSelection = QTableWidgetSelectionRange(0, 0, 0, 0);
-
-    // set row/col counts
-    ui->tableChords->setRowCount(chordNames.length() - 1);
-    ui->tableChords->setColumnCount(chordNames.length() - 1);
-
-    // set headers
-    ui->tableChords->setHorizontalHeaderLabels(chordNames.mid(1));
-    ui->tableChords->setVerticalHeaderLabels(chordNames);
-
-    // loop rows and cols
-    int row = 0, col = 0;
-    foreach (auto rowChord, chords.mid(0, chords.length() - 1)) {
-        // reset col
-        col = 0;
-        foreach (auto colChord, chords.mid(1, chords.length() - 1)) {
-            // create item
-            QTableWidgetItem *item = new QTableWidgetItem();
-
-            // duplicate?
-            if (row > col) {
-                // disable it
-                item->setBackground(Qt::black);
-            }
-            else {
-                // get chord pair
-                auto minMaxIds = std::minmax({rowChord.id, colChord.id});
-                ChordPair pair = ChordPair::getOrCreate(minMaxIds.first, minMaxIds.second);
-
-                // current?
-                if (current.id == pair.id) {
-                    currentSelection = QTableWidgetSelectionRange(row, col, row, col);
-                }
-
-                // get all counts
-                auto counts = pair.counts();
-
-                // what did we get?
-                if (counts.length() > 0) {
-                    // set text
-                    auto count = counts.last().count;
-                    item->setText(QString::number(count));
-
-                    // color
-                    if (count > 60)
-                        item->setBackground(QColor::fromRgb(47, 87, 47));
-                    else if (count > 40)
-                        item->setBackground(QColor::fromRgb(99, 99, 59));
-                    else if (count > 20)
-                        item->setBackground(QColor::fromRgb(100, 70, 28));
-                    else
-                        item->setBackground(QColor::fromRgb(100, 41, 38));
-                }
-
-                // store chords
-                item->setData(Qt::UserRole, pair.id);
-            }
-
-            // set it
-            ui->tableChords->setItem(row, col, item);
 
-            // next column
-            col++;
-        }
+    // update model, which only resets if chords changed
+    matrixModel->setMatrix(chords, pairs);
+    recommender.setPairs(chords, pairs);
 
-        // next row
-        row++;
+    // column width from longest chord name, or a count with four digits
+    auto metrics = ui->tableChords->horizontalHeader()->fontMetrics();
+    int width = metrics.horizontalAdvance("0000");
+    foreach (auto chord, chords) {
+        width = std::max(width, metrics.horizontalAdvance(chord.name));
     }
+    ui->tableChords->horizontalHeader()->setDefaultSectionSize(width + 12);
 
-    // adjust size
-    ui->tableChords->resizeColumnsToContents();
-    ui->tableChords->resizeRowsToContents();
-
-    // select current
-    ui->tableChords->clearSelection();
-    ui->tableChords->setRangeSelected(currentSelection, true);
+    // select current again, if it got lost
+    auto index = matrixModel->indexOf(current.chord1_id, current.chord2_id);
+    if (index.isValid() && index != ui->tableChords->currentIndex()) {
+        ui->tableChords->setCurrentIndex(index);
+    }
 }
 
-void MainWindow::updateChordList()
+void MainWindow::updateChordList(const QList<Chord> &chords)
 {
     // clear list
     ui->listChords->clear();
 
-    // get all chords
-    foreach (auto chord, Chord::list()) {
+    // add all chords
+    foreach (auto chord, chords) {
         ui->listChords->addItem(chord.name);
     }
 }
 
-void MainWindow::updateHistory()
+void MainWindow::setupColors()
 {
-    // clear history
-    ui->tableHistory->setRowCount(0);
+    // colours from settings
+    ColorScale scale;
+    scale.load(settings);
+    matrixModel->setColorScale(scale);
+
+    // switch between bands and gradient in context menu
+    auto gradient = new QAction("Continuous colours", this);
+    gradient->setCheckable(true);
+    gradient->setChecked(scale.isContinuous());
+    connect(gradient, &QAction::toggled, this, [this](bool checked) {
+        auto scale = matrixModel->colorScale();
+        scale.setContinuous(checked);
+        scale.save(settings);
+        matrixModel->setColorScale(scale);
+    });
+
+    // thresholds in context menu
+    auto thresholds = new QAction("Colour thresholds...", this);
+    connect(thresholds, &QAction::triggered, this, &MainWindow::editColorThresholds);
+
+    // add them
+    ui->tableChords->setContextMenuPolicy(Qt::ActionsContextMenu);
+    ui->tableChords->addActions({gradient, thresholds});
+}
 
-    // get counts
-    auto pair = selectedPair();
-    auto counts = pair.counts();
-
-    // got something?
-    if (counts.length() > 0) {
-        // adjust table
-        ui->tableHistory->setRowCount(counts.length());
-
-        // add them
-        int row = 0;
-        foreach (auto count, counts) {
-            // items
-            ui->tableHistory->setItem(row, 0, new QTableWidgetItem(count.time.toString()));
-            auto item = new QTableWidgetItem(QString::number(count.count));
-            item->setData(Qt::UserRole, count.id);
-            ui->tableHistory->setItem(row, 1, item);
-
-            // next row
-            row++;
-        }
+void MainWindow::editColorThresholds()
+{
+    // current thresholds as text
+    auto scale = matrixModel->colorScale();
+    QStringList values;
+    foreach (auto stop, scale.thresholds()) {
+        values.append(QString::number(stop));
+    }
 
-        // adjust size
-        ui->tableHistory->resizeColumnToContents(0);
+    // ask
+    bool ok;
+    QString text = QInputDialog::getText(this, "Colour thresholds", "Enter increasing counts, separated by commas:",
+                                         QLineEdit::Normal, values.join(", "), &ok);
+    if (!ok)
+        return;
+
+    // parse
+    QList<int> thresholds;
+    foreach (auto value, text.split(",")) {
+        int stop = value.trimmed().toInt(&ok);
+        if (!ok || (!thresholds.isEmpty() && stop <= thresholds.last())) {
+            QMessageBox::warning(this, "Colour thresholds", "Thresholds must be increasing numbers.");
+            return;
+        }
+        thresholds.append(stop);
     }
 
-    // plot
+    // store and apply, which rebuilds the lookup table once
+    scale.setThresholds(thresholds);
+    scale.save(settings);
+    matrixModel->setColorScale(scale);
+}
+
+void MainWindow::setupMetronome()
+{
+    // switch clicks on and off in context menu of start button
+    auto enabled = new QAction("Metronome", this);
+    enabled->setCheckable(true);
+    enabled->setChecked(settings.value("metronome/enabled", false).toBool());
+    connect(enabled, &QAction::toggled, this, [this](bool checked) {
+        settings.setValue("metronome/enabled", checked);
+    });
+
+    // tempo in context menu
+    auto tempo = new QAction("Metronome tempo...", this);
+    connect(tempo, &QAction::triggered, this, &MainWindow::editMetronomeTempo);
+
+    // add them
+    ui->buttonStart->setContextMenuPolicy(Qt::ActionsContextMenu);
+    ui->buttonStart->addActions({enabled, tempo});
+}
+
+void MainWindow::editMetronomeTempo()
+{
+    // ask for beats per minute, used from the next session on
+    bool ok;
+    double bpm = QInputDialog::getDouble(this, "Metronome tempo", "Enter beats per minute:",
+                                         settings.value("metronome/bpm", 60.).toDouble(), 20., 300., 0, &ok);
+    if (ok)
+        settings.setValue("metronome/bpm", bpm);
+}
+
+void MainWindow::updateHistory()
+{
+    // table loads its pages by itself
+    historyModel->setPair(selectedPair());
+
+    // plot all selected pairs
     updatePlot();
 }
 
 ChordPair MainWindow::selectedPair()
 {
-    // get item
-    auto item = ui->tableChords->currentItem();
-    if (!item)
-        return ChordPair::empty();
+    // get pair for current cell, disabled cells have no chords
+    auto pair = matrixModel->pair(ui->tableChords->currentIndex());
+    if (pair.isEmpty())
+        return pair;
 
-    // get pair
-    return ChordPair::getById(item->data(Qt::UserRole).toInt());
+    // get full pair
+    return ChordPair::get(pair.chord1_id, pair.chord2_id);
 }
 
 void MainWindow::startTimer()
@@ -191,16 +255,21 @@ void MainWindow::startTimer()
     // disable GUI
     ui->frameChords->setEnabled(false);
     ui->frameHistory->setEnabled(false);
-
-    // start timer
-    timerStart = QDateTime::currentDateTime();
-    timer.start(200);
+    ui->buttonNext->setEnabled(false);
+
+    // start clicks and clock together, so that both count from the same moment
+    if (settings.value("metronome/enabled", false).toBool())
+        metronome.start(settings.value("metronome/bpm", 60.).toDouble());
+    sessionClock.start();
+    timerNext = -1;
+    timerUpdate();
 }
 
 void MainWindow::stopTimer(bool ask)
 {
-    // stop timer
+    // stop timer and clicks
     timer.stop();
+    metronome.stop();
 
     // stop, change button text
     ui->buttonStart->setText("Start");
@@ -209,6 +278,7 @@ void MainWindow::stopTimer(bool ask)
     // enable GUI
     ui->frameChords->setEnabled(true);
     ui->frameHistory->setEnabled(true);
+    ui->buttonNext->setEnabled(true);
 
     // ask for adding?
     if (ask) {
@@ -216,46 +286,326 @@ void MainWindow::stopTimer(bool ask)
     }
 }
 
+void MainWindow::setupPlot()
+{
+    // give the axes some labels:
+    ui->plotHistory->xAxis->setLabel("Days from start of app");
+    ui->plotHistory->yAxis->setLabel("Count");
+
+    // legend for when multiple pairs are shown
+    ui->plotHistory->legend->setVisible(false);
+    ui->plotHistory->axisRect()->insetLayout()->setInsetAlignment(0, Qt::AlignTop | Qt::AlignLeft);
+
+    // all series are converted relative to the same fixed time
+    plotNow = QDateTime::currentMSecsSinceEpoch();
+
+    // trend lines for current pair, below all series
+    meanGraph = ui->plotHistory->addGraph();
+    meanGraph->setName("Rolling mean");
+    meanGraph->setPen(QPen(Qt::gray, 1.5));
+    ewmaGraph = ui->plotHistory->addGraph();
+    ewmaGraph->setName("Weighted average");
+    ewmaGraph->setPen(QPen(QColor(255, 140, 0), 1.5));
+    fitGraph = ui->plotHistory->addGraph();
+    fitGraph->setPen(QPen(Qt::red, 1.5, Qt::DashLine));
+    foreach (auto graph, QList<QCPGraph*>({meanGraph, ewmaGraph, fitGraph})) {
+        graph->setAdaptiveSampling(true);
+        graph->setVisible(false);
+        graph->removeFromLegend();
+    }
+    trendPair = -1;
+
+    // allow zooming, data is resampled to the visible range before every replot
+    ui->plotHistory->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    connect(ui->plotHistory, &QCustomPlot::beforeReplot, this, &MainWindow::resamplePlot);
+}
+
 void MainWindow::updatePlot()
 {
-    // get selected pair and counts
-    auto pair = selectedPair();
-    if (pair.isEmpty())
-        return;
-    auto counts = pair.counts();
+    // get stored pairs of all selected cells, and those of them that need loading
+    QSet<int> selected;
+    QList<int> missing;
+    foreach (auto index, ui->tableChords->selectionModel()->selectedIndexes()) {
+        auto pair = matrixModel->pair(index);
+        if (!pair.exists())
+            continue;
+        selected.insert(pair.id);
+        if (!plotSeries.contains(pair.id) && !plotLoading.contains(pair.id))
+            missing.append(pair.id);
+    }
+
+    // give graphs of pairs that are no longer shown back to the pool
+    for (auto it = plotShown.begin(); it != plotShown.end();) {
+        if (selected.contains(it.key()) && plotSeries.contains(it.key())) {
+            ++it;
+            continue;
+        }
+        it.value()->setVisible(false);
+        it.value()->removeFromLegend();
+        it.value()->data()->clear();
+        plotFree.append(it.value());
+        it = plotShown.erase(it);
+    }
 
-    // get now and minimum x
-    auto now = QDateTime::currentDateTime();
-    float minX = 0, maxY = 0;
+    // show selected series, highlight the current one
+    int current = selectedPair().id;
+    foreach (auto id, selected) {
+        auto series = plotSeries.find(id);
+        if (series == plotSeries.end())
+            continue;
+        auto graph = plotShown.value(id);
+        if (!graph) {
+            graph = showPlotSeries(id);
+            series->sampledPoints = -1;
+        }
+        graph->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, graph->pen().color(),
+                                               graph->pen().color(), id == current ? 6 : 4));
+    }
+    ui->plotHistory->legend->setVisible(plotShown.size() > 1);
 
-    // get data
+    // load missing series in a single request
+    if (!missing.isEmpty()) {
+        foreach (auto id, missing) {
+            plotLoading.insert(id);
+        }
+        whenReady(Worker::run([missing]() {
+            QHash<int, QList<ChordCount>> counts;
+            foreach (auto id, missing) {
+                counts.insert(id, ChordCount::listForPair(id));
+            }
+            return counts;
+        }), [this](const QHash<int, QList<ChordCount>> &counts) {
+            // add them to cache and show them, if still selected
+            for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+                plotLoading.remove(it.key());
+
+                // counts stored while loading are newer, but might have been loaded already
+                auto list = it.value();
+                QSet<int> loaded;
+                foreach (auto count, list) {
+                    loaded.insert(count.id);
+                }
+                foreach (auto count, plotPending.take(it.key())) {
+                    if (!loaded.contains(count.id))
+                        list.append(count);
+                }
+                addPlotSeries(it.key(), list);
+            }
+            updatePlot();
+        });
+    }
+
+    // replot
+    replotHistory();
+}
+
+QCPGraph *MainWindow::showPlotSeries(int pair_id)
+{
+    // reuse an unused graph, so that their number is bounded by the selection
+    QCPGraph *graph;
+    if (!plotFree.isEmpty()) {
+        graph = plotFree.takeLast();
+    }
+    else {
+        graph = ui->plotHistory->addGraph();
+        graph->setLineStyle(QCPGraph::lsNone);
+        graph->setAdaptiveSampling(true);
+    }
+
+    // first colour not used by any other shown series
+    static const QList<QColor> colors = {Qt::blue, Qt::red, Qt::darkGreen, Qt::magenta, Qt::darkCyan,
+                                         Qt::darkYellow, Qt::darkRed, Qt::darkBlue, Qt::darkMagenta, Qt::gray};
+    QSet<QRgb> used;
+    foreach (auto shown, plotShown) {
+        used.insert(shown->pen().color().rgb());
+    }
+    auto color = colors[plotShown.size() % colors.length()];
+    foreach (auto c, colors) {
+        if (!used.contains(c.rgb())) {
+            color = c;
+            break;
+        }
+    }
+
+    // name and colour of pair
+    auto pair = ChordPair::getById(pair_id);
+    graph->setName(QString("%1 <-> %2").arg(pair.chord1().name).arg(pair.chord2().name));
+    graph->setPen(QPen(color));
+    graph->setVisible(true);
+    graph->addToLegend();
+    plotShown.insert(pair_id, graph);
+    return graph;
+}
+
+void MainWindow::addPlotSeries(int pair_id, const QList<ChordCount> &counts)
+{
+    // convert counts once into days from start and counts, sorted by time already
+    PlotSeries series;
     int n = counts.length();
-    QVector<double> x(n), y(n);
+    series.x.resize(n);
+    series.y.resize(n);
+    series.minX = 0;
+    series.maxX = 0;
+    series.maxY = 0;
     for (int i=0; i<n; ++i)
     {
-        x[i] = -counts[i].time.secsTo(now) / 86400.;
-        if (x[i] < minX)
-            minX = x[i];
-        y[i] = counts[i].count;
-        if (y[i] > maxY)
-            maxY = y[i];
+        series.x[i] = (counts[i].time - plotNow) / 86400000.;
+        series.y[i] = counts[i].count;
+        series.minX = std::min(series.minX, series.x[i]);
+        series.maxX = std::max(series.maxX, series.x[i]);
+        series.maxY = std::max(series.maxY, series.y[i]);
     }
-    auto marginX = std::max(0.1, -minX * 0.1), marginY = std::max(0.1, maxY * 0.1);
+    series.sampledPoints = -1;
+    series.statsValid = false;
+    plotSeries.insert(pair_id, series);
+}
 
-    // create graph and assign data to it:
-    ui->plotHistory->addGraph();
-    ui->plotHistory->graph(0)->setData(x, y);
-    ui->plotHistory->graph(0)->setLineStyle(QCPGraph::lsNone);
-    ui->plotHistory->graph(0)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, Qt::blue, Qt::blue, 5));
+void MainWindow::removePlotSeries(int pair_id)
+{
+    // drop cached data, e.g. after a count has been deleted, graph is released on next update
+    plotSeries.remove(pair_id);
+    plotPending.remove(pair_id);
+}
 
-    // give the axes some labels:
-    ui->plotHistory->xAxis->setLabel("Days from now");
-    ui->plotHistory->yAxis->setLabel("Count");
+void MainWindow::appendPlot(const ChordCount &count)
+{
+    // not loaded yet? then keep it for when loading finishes, or load it together with everything else
+    auto it = plotSeries.find(count.chords_id);
+    if (it == plotSeries.end()) {
+        if (plotLoading.contains(count.chords_id))
+            plotPending[count.chords_id].append(count);
+        else
+            updatePlot();
+        return;
+    }
+
+    // add single point to cache, graph gets resampled on replot
+    double x = (count.time - plotNow) / 86400000., y = count.count;
+    it->x.append(x);
+    it->y.append(y);
+    it->minX = std::min(it->minX, x);
+    it->maxX = std::max(it->maxX, x);
+    it->maxY = std::max(it->maxY, y);
+    it->sampledPoints = -1;
+    it->statsValid = false;
+    replotHistory();
+}
+
+void MainWindow::resamplePlot()
+{
+    // one bucket per pixel of the visible range
+    auto range = ui->plotHistory->xAxis->range();
+    int width = ui->plotHistory->axisRect()->width();
+
+    // resample shown series, if anything changed since last time
+    for (auto shown = plotShown.constBegin(); shown != plotShown.constEnd(); ++shown) {
+        auto it = plotSeries.find(shown.key());
+        if (it == plotSeries.end())
+            continue;
+        if (it->sampledPoints == it->x.size() && it->sampledRange == range && it->sampledWidth == width)
+            continue;
+
+        // keep lowest and highest count per pixel, so that no outlier vanishes
+        QVector<double> x, y;
+        Sampling::minMax(it->x, it->y, range.lower, range.upper, width, x, y);
+        shown.value()->setData(x, y, true);
+        it->sampledPoints = it->x.size();
+        it->sampledRange = range;
+        it->sampledWidth = width;
+    }
+}
+
+void MainWindow::updateTrend()
+{
+    // trend is only shown for the current pair
+    int current = selectedPair().id;
+    auto it = plotSeries.find(current);
+    bool show = it != plotSeries.end() && plotShown.contains(current) && it->x.size() >= 2;
+    foreach (auto graph, QList<QCPGraph*>({meanGraph, ewmaGraph, fitGraph})) {
+        graph->setVisible(show);
+        graph->removeFromLegend();
+        if (show)
+            graph->addToLegend();
+    }
+    if (!show) {
+        trendPair = -1;
+        return;
+    }
+    ui->plotHistory->legend->setVisible(true);
+
+    // calculate statistics, if series changed
+    if (!it->statsValid) {
+        int n = it->x.size();
+        it->mean.resize(n);
+        it->ewma.resize(n);
+        Stats::rollingMean(it->y.constData(), n, 5, it->mean.data());
+        Stats::ewma(it->y.constData(), n, 0.3, it->ewma.data());
+        if (!Stats::linearFit(it->x.constData(), it->y.constData(), n, &it->slope, &it->intercept)) {
+            it->slope = 0;
+            it->intercept = Stats::mean(it->y.constData(), n);
+        }
+        it->statsValid = true;
+        trendPair = -1;
+    }
+
+    // set data, if anything changed
+    if (trendPair != current) {
+        meanGraph->setData(it->x, it->mean, true);
+        ewmaGraph->setData(it->x, it->ewma, true);
+        double x0 = it->x.first(), x1 = it->x.last();
+        fitGraph->setData(QVector<double>({x0, x1}),
+                          QVector<double>({it->slope * x0 + it->intercept, it->slope * x1 + it->intercept}), true);
+        fitGraph->setName(QString("Trend: %1 per day").arg(it->slope, 0, 'f', 2));
+        trendPair = current;
+    }
+}
+
+void MainWindow::replotHistory()
+{
+    // trend of current pair
+    updateTrend();
+
+    // get extent of all shown series, up to now
+    double minX = 0, maxX = (QDateTime::currentMSecsSinceEpoch() - plotNow) / 86400000., maxY = 0;
+    foreach (auto id, plotShown.keys()) {
+        auto series = plotSeries.constFind(id);
+        if (series == plotSeries.constEnd())
+            continue;
+        minX = std::min(minX, series->minX);
+        maxX = std::max(maxX, series->maxX);
+        maxY = std::max(maxY, series->maxY);
+    }
 
     // set axes ranges, so we see all data:
-    ui->plotHistory->xAxis->setRange(minX - marginX, marginX);
+    auto marginX = std::max(0.1, (maxX - minX) * 0.1), marginY = std::max(0.1, maxY * 0.1);
+    ui->plotHistory->xAxis->setRange(minX - marginX, maxX + marginX);
     ui->plotHistory->yAxis->setRange(-marginY, maxY + marginY);
-    ui->plotHistory->replot();
+
+    // queue replot for next event loop iteration, so that multiple updates only render once
+    ui->plotHistory->replot(QCustomPlot::rpQueuedReplot);
+}
+
+void MainWindow::updateAnalytics()
+{
+    // aggregates are kept up to date by the data layer, so only the first call needs a scan,
+    // later ones just rebuild the tables, e.g. after a chord has been removed
+    if (Analytics::isLoaded()) {
+        pairStatsModel->reload();
+        chordStatsModel->reload();
+        return;
+    }
+    whenReady(Worker::run([]() { Analytics::load(); return true; }), [this](bool) {
+        recommender.rescore();
+        pairStatsModel->reload();
+        chordStatsModel->reload();
+    });
+}
+
+void MainWindow::updatePairAnalytics(int pair_id)
+{
+    // only rows of the changed pair and its chords
+    pairStatsModel->updatePair(pair_id);
+    chordStatsModel->updatePair(pair_id);
 }
 
 void MainWindow::on_buttonAddChord_clicked()
@@ -263,12 +613,9 @@ void MainWindow::on_buttonAddChord_clicked()
     bool ok;
     QString name = QInputDialog::getText(this, "New chord", "Enter name for new chord:", QLineEdit::Normal, "", &ok);
     if (ok && !name.isEmpty()) {
-        // add chord
-        Chord::getOrCreate(name);
-
-        // update gui
-        updateChordList();
-        updateChordTable();
+        // add chord and update gui
+        whenReady(Worker::run([name]() { return Chord::getOrCreate(name); }),
+                  [this](const Chord &) { updateChords(); });
     }
 }
 
@@ -285,12 +632,9 @@ void MainWindow::on_buttonRemoveChord_clicked()
     // ask
     auto r = QMessageBox::question(this, "Delete chord", QString("Really delete chord \"%1\"?").arg(chordName), QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
     if (r == QMessageBox::Yes) {
-        // remove chord
-        Chord::remove(chordName);
-
-        // update gui
-        updateChordList();
-        updateChordTable();
+        // remove chord and update gui
+        whenReady(Worker::run([chordName]() { return Chord::remove(chordName); }),
+                  [this](bool) { updateChords(); updateAnalytics(); });
     }
 }
 
@@ -300,7 +644,7 @@ void MainWindow::chordPair_selected()
     auto pair = selectedPair();
 
     // something?
-    if (pair.id == -1) {
+    if (pair.isEmpty()) {
         // no, remove label
         ui->labelChords->clear();
 
@@ -317,46 +661,110 @@ void MainWindow::chordPair_selected()
         ui->buttonStart->setEnabled(true);
     }
 
-    // update history
-    updateHistory();
+    // update history, but only once for all selection changes in this event loop iteration
+    historyTimer.start();
 }
 
 void MainWindow::on_buttonAddHistory_clicked()
+{
+    addHistory();
+}
+
+void MainWindow::on_buttonAddFromRecording_clicked()
+{
+    // get recording
+    auto filename = QFileDialog::getOpenFileName(this, "Open recording", QString(), "WAV files (*.wav)");
+    if (filename.isEmpty())
+        return;
+
+    // count changes of a one minute session in background
+    whenReady(Worker::run([filename]() {
+        QVector<float> samples;
+        int sampleRate;
+        if (!WavFile::read(filename, &samples, &sampleRate))
+            return -1;
+        OnsetDetector detector(sampleRate);
+        detector.process(samples.constData(), int(samples.size()));
+        detector.finish();
+        return detector.changes(60.);
+    }), [this](int count) {
+        // let user confirm or correct it
+        if (count < 0)
+            QMessageBox::warning(this, "Open recording", "Could not read recording.");
+        else
+            addHistory(count);
+    });
+}
+
+void MainWindow::addHistory(int proposed)
 {
     bool ok;
-    int count = QInputDialog::getInt(this, "New count", "Enter number of changes:", 0, 0, 1000, 1, &ok);
+    int count = QInputDialog::getInt(this, "New count", "Enter number of changes:", proposed, 0, 1000, 1, &ok);
     if (ok) {
         // get pair
         auto pair = selectedPair();
+        if (pair.isEmpty())
+            return;
+
+        // add history, store pair if this is its first count
+        whenReady(Worker::run([pair, count]() {
+            Transaction transaction;
+            auto stored = ChordPair::getOrCreate(pair.chord1_id, pair.chord2_id);
+            auto created = ChordCount::create(stored.id, count);
+            bool ok = stored.exists() && created.exists() && transaction.commit();
+
+            // analytics have been updated on commit already
+            PairStats stats{stored.id, 0, 0, 0, 0., 0., 0};
+            Analytics::pair(stored.id, &stats);
+            return StoredCount{ok, ok ? ChordPair::getById(stored.id) : pair, created, stats};
+        }), [this](const StoredCount &result) {
+            // nothing has been stored?
+            if (!result.ok) {
+                QMessageBox::critical(this, "New count", "Could not store count.");
+                return;
+            }
 
-        // add history
-        ChordCount::create(pair.id, count);
-
-        // update gui
-        updateChordTable();
-        updateHistory();
+            // update gui, only adding the new count
+            matrixModel->updatePair(result.pair);
+            recommender.update(result.pair, result.stats);
+            historyModel->addCount(result.pair, result.count);
+            appendPlot(result.count);
+            updatePairAnalytics(result.pair.id);
+        });
     }
 }
 
 void MainWindow::on_buttonRemoveHistory_clicked()
 {
-    // get item
-    auto item = ui->tableHistory->item(ui->tableHistory->currentRow(), 1);
-    if (!item)
+    // get count id
+    auto id = historyModel->countId(ui->tableHistory->currentIndex().row());
+    if (id < 0)
         return;
 
     // ask
     auto r = QMessageBox::question(this, "Delete count", QString("Really delete count?"), QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
     if (r == QMessageBox::Yes) {
-        // get count id
-        auto id = item->data(Qt::UserRole).toInt();
-
-        // remove count
-        ChordCount::remove(id);
+        // get pair
+        auto pair = selectedPair();
 
-        // update gui
-        updateChordTable();
-        updateHistory();
+        // remove count and update gui
+        whenReady(Worker::run([id, pair]() {
+            ChordCount::remove(id);
+
+            // pair and its statistics, which have been updated on commit
+            auto changed = ChordPair::get(pair.chord1_id, pair.chord2_id);
+            PairStats stats{changed.id, 0, 0, 0, 0., 0., 0};
+            Analytics::pair(changed.id, &stats);
+            return qMakePair(changed, stats);
+        }), [this](const QPair<ChordPair, PairStats> &result) {
+            // update gui, reloading the whole history
+            auto changed = result.first;
+            matrixModel->updatePair(changed);
+            recommender.update(changed, result.second);
+            removePlotSeries(changed.id);
+            updateHistory();
+            updatePairAnalytics(changed.id);
+        });
     }
 }
 
@@ -369,24 +777,51 @@ void MainWindow::on_buttonStart_clicked()
         stopTimer();
 }
 
+void MainWindow::on_buttonNext_clicked()
+{
+    // best pair other than the current one
+    auto pair = recommender.next(selectedPair());
+    auto index = matrixModel->indexOf(pair.chord1_id, pair.chord2_id);
+    if (!index.isValid())
+        return;
+
+    // select it and start
+    ui->tableChords->setCurrentIndex(index);
+    startTimer();
+}
+
 void MainWindow::timerUpdate()
 {
-    // diff to now
-    auto diff = timerStart.msecsTo(QDateTime::currentDateTime()) / 1000.;
-    auto duration = 60;
+    // session length and end of countdown and "GO!", in ms
+    const qint64 duration = 60000, countdown = 3000, go = 5000;
 
-    // what do we show?
-    if (diff > duration) {
+    // done?
+    qint64 elapsed = sessionClock.elapsed();
+    if (elapsed >= duration) {
         stopTimer(true);
+        return;
     }
-    else if (diff > 5) {
-        ui->labelTimer->setText(QString::number(duration - diff, 'f', 1) + QString("s"));
-    }
-    else if (diff > 3) {
-        ui->labelTimer->setText("GO!");
-    }
-    else {
-        ui->labelTimer->setText(QString::number(floor(4 - diff), 'f', 0));
+
+    // when does the shown value change next? which also identifies the value
+    qint64 next, remaining = (duration - elapsed + 99) / 100;
+    if (elapsed < countdown)
+        next = (elapsed / 1000 + 1) * 1000;
+    else if (elapsed < go)
+        next = go;
+    else
+        next = duration - (remaining - 1) * 100;
+
+    // only update label if value has changed
+    if (next != timerNext) {
+        timerNext = next;
+        if (elapsed < countdown)
+            ui->labelTimer->setText(QString::number(3 - elapsed / 1000));
+        else if (elapsed < go)
+            ui->labelTimer->setText("GO!");
+        else
+            ui->labelTimer->setText(QString("%1.%2s").arg(remaining / 10).arg(remaining % 10));
     }
-}
 
+    // wake up exactly then
+    timer.start(int(next - elapsed));
+}
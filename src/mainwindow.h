@@ -1,11 +1,22 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QFutureWatcher>
 #include <QMainWindow>
+#include <QSet>
+#include <QSettings>
 #include <QSqlDatabase>
 #include <QTimer>
 #include <sqlite3.h>
+#include "3rdparty/qcustomplot/qcustomplot.h"
+#include "analyticsmodel.h"
+#include "historymodel.h"
+#include "matrixmodel.h"
+#include "metronome.h"
 #include "models.h"
+#include "recommender.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -21,27 +32,111 @@ public:
 
 private:
     Ui::MainWindow *ui;
+    ChordMatrixModel *matrixModel;
+    HistoryModel *historyModel;
+    PairStatsModel *pairStatsModel;
+    ChordStatsModel *chordStatsModel;
 
-    QTimer timer;
-    QDateTime timerStart;
+    QTimer timer, historyTimer;
+
+    // monotonic session clock, and time in ms at which the shown value changes next
+    QElapsedTimer sessionClock;
+    qint64 timerNext;
+
+    // audible countdown and beat, started together with the session clock
+    Metronome metronome;
     QSqlDatabase *db;
+    QSettings settings;
+
+    // id of latest background request, older results are dropped
+    int chordsRequest;
+
+    // converted history of a pair, kept while the app runs, plus size, range
+    // and pixel width its graph data has been resampled for, and statistics
+    struct PlotSeries
+    {
+        QVector<double> x, y;
+        double minX, maxX, maxY;
+        int sampledPoints, sampledWidth;
+        QCPRange sampledRange;
+        bool statsValid;
+        QVector<double> mean, ewma;
+        double slope, intercept;
+    };
+
+    // fixed reference time for plot, plus cached series, those being loaded and
+    // counts stored meanwhile, by pair id
+    qint64 plotNow;
+    QHash<int, PlotSeries> plotSeries;
+    QSet<int> plotLoading;
+    QHash<int, QList<ChordCount>> plotPending;
+
+    // graphs of shown series by pair id, and unused ones to be reused
+    QHash<int, QCPGraph*> plotShown;
+    QList<QCPGraph*> plotFree;
+
+    // trend lines and the pair they currently show
+    QCPGraph *meanGraph, *ewmaGraph, *fitGraph;
+    int trendPair;
+
+    // result of storing a count in background, with the updated statistics of its pair
+    struct StoredCount
+    {
+        bool ok;
+        ChordPair pair;
+        ChordCount count;
+        PairStats stats;
+    };
+
+    // suggests which pair to practise next
+    Recommender recommender;
 
     void initDatabase();
-    void updateChordTable();
-    void updateChordList();
+    void updateChords();
+    void updateChordTable(const QList<Chord> &chords, const QHash<QPair<int, int>, ChordPair> &pairs);
+    void updateChordList(const QList<Chord> &chords);
+    void setupColors();
+    void editColorThresholds();
+    void setupMetronome();
+    void editMetronomeTempo();
     void updateHistory();
     ChordPair selectedPair();
     void startTimer();
     void stopTimer(bool ask = false);
+    void setupPlot();
     void updatePlot();
+    QCPGraph *showPlotSeries(int pair_id);
+    void addPlotSeries(int pair_id, const QList<ChordCount> &counts);
+    void removePlotSeries(int pair_id);
+    void appendPlot(const ChordCount &count);
+    void resamplePlot();
+    void updateTrend();
+    void replotHistory();
+    void updateAnalytics();
+    void updatePairAnalytics(int pair_id);
+    void addHistory(int proposed = 0);
+
+    // call callback with result of future in GUI thread, once it is finished
+    template <typename T, typename F>
+    void whenReady(const QFuture<T> &future, F callback)
+    {
+        auto watcher = new QFutureWatcher<T>(this);
+        connect(watcher, &QFutureWatcher<T>::finished, this, [watcher, callback]() {
+            callback(watcher->result());
+            watcher->deleteLater();
+        });
+        watcher->setFuture(future);
+    }
 
 private slots:
     void on_buttonAddChord_clicked();
     void on_buttonRemoveChord_clicked();
     void chordPair_selected();
     void on_buttonAddHistory_clicked();
+    void on_buttonAddFromRecording_clicked();
     void on_buttonRemoveHistory_clicked();
     void on_buttonStart_clicked();
+    void on_buttonNext_clicked();
     void timerUpdate();
 };
 #endif // MAINWINDOW_H
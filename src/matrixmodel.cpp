@@ -0,0 +1,175 @@
+#include "matrixmodel.h"
+
+#include <QColor>
+#include <algorithm>
+
+ChordMatrixModel::ChordMatrixModel(QObject *parent) : QAbstractTableModel(parent)
+{
+
+}
+
+int ChordMatrixModel::rowCount(const QModelIndex &parent) const
+{
+    // first chord to second last
+    return parent.isValid() ? 0 : std::max(0, chordList.length() - 1);
+}
+
+int ChordMatrixModel::columnCount(const QModelIndex &parent) const
+{
+    // second chord to last
+    return parent.isValid() ? 0 : std::max(0, chordList.length() - 1);
+}
+
+QVariant ChordMatrixModel::data(const QModelIndex &index, int role) const
+{
+    // valid?
+    if (!index.isValid())
+        return QVariant();
+
+    // duplicate?
+    static const QVariant black = QColor(Qt::black);
+    int i = cellIndex(index.row(), index.column());
+    if (i < 0)
+        return role == Qt::BackgroundRole ? black : QVariant();
+
+    // never practised?
+    int count = cells[i].latest_count;
+    if (count < 0)
+        return QVariant();
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return count;
+    case Qt::TextAlignmentRole:
+        return int(Qt::AlignCenter);
+    case Qt::BackgroundRole:
+        return scale.color(count);
+    default:
+        return QVariant();
+    }
+}
+
+QVariant ChordMatrixModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    // only names
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    // columns start at second chord
+    int i = orientation == Qt::Horizontal ? section + 1 : section;
+    return i >= 0 && i < chordList.length() ? QVariant(chordList[i].name) : QVariant();
+}
+
+Qt::ItemFlags ChordMatrixModel::flags(const QModelIndex &index) const
+{
+    // lower triangle can't be selected
+    if (!index.isValid() || cellIndex(index.row(), index.column()) < 0)
+        return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+void ChordMatrixModel::setMatrix(const QList<Chord> &chords, const QHash<QPair<int, int>, ChordPair> &pairs)
+{
+    // same chords?
+    bool sameChords = chords.length() == chordList.length();
+    for (int i = 0; sameChords && i < chords.length(); ++i)
+        sameChords = chords[i].id == chordList[i].id && chords[i].name == chordList[i].name;
+
+    // build cells
+    QVector<Cell> newCells;
+    newCells.reserve(chords.length() * (chords.length() - 1) / 2);
+    for (int i = 0; i < chords.length(); ++i) {
+        for (int j = i + 1; j < chords.length(); ++j) {
+            auto minMaxIds = std::minmax({chords[i].id, chords[j].id});
+            newCells.append(cellFor(minMaxIds.first, minMaxIds.second, pairs));
+        }
+    }
+
+    // if chords are the same, only signal changed cells
+    if (sameChords) {
+        for (int row = 0; row < rowCount(); ++row) {
+            for (int col = row; col < columnCount(); ++col) {
+                int i = cellIndex(row, col);
+                if (!(cells[i] == newCells[i])) {
+                    cells[i] = newCells[i];
+                    emit dataChanged(index(row, col), index(row, col));
+                }
+            }
+        }
+        return;
+    }
+
+    // otherwise reset everything
+    beginResetModel();
+    chordList = chords;
+    chordIndex.clear();
+    for (int i = 0; i < chordList.length(); ++i)
+        chordIndex.insert(chordList[i].id, i);
+    cells = newCells;
+    endResetModel();
+}
+
+void ChordMatrixModel::updatePair(const ChordPair &pair)
+{
+    // find cell
+    auto idx = indexOf(pair.chord1_id, pair.chord2_id);
+    if (!idx.isValid())
+        return;
+
+    // update it
+    int i = cellIndex(idx.row(), idx.column());
+    cells[i] = Cell{pair.id, pair.latest_count};
+    emit dataChanged(idx, idx);
+}
+
+void ChordMatrixModel::setColorScale(const ColorScale &colorScale)
+{
+    // repaint all cells
+    scale = colorScale;
+    if (rowCount() > 0)
+        emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1), {Qt::BackgroundRole});
+}
+
+ChordPair ChordMatrixModel::pair(const QModelIndex &index) const
+{
+    // valid cell?
+    int i = index.isValid() ? cellIndex(index.row(), index.column()) : -1;
+    if (i < 0)
+        return ChordPair::empty();
+
+    // build pair
+    auto minMaxIds = std::minmax({chordList[index.row()].id, chordList[index.column() + 1].id});
+    return ChordPair(cells[i].pair_id, minMaxIds.first, minMaxIds.second, cells[i].latest_count);
+}
+
+QModelIndex ChordMatrixModel::indexOf(int chord1_id, int chord2_id) const
+{
+    // find chords
+    if (!chordIndex.contains(chord1_id) || !chordIndex.contains(chord2_id))
+        return QModelIndex();
+
+    // cell is in row of first chord in list and column of second one
+    auto minMax = std::minmax({chordIndex[chord1_id], chordIndex[chord2_id]});
+    if (minMax.first == minMax.second)
+        return QModelIndex();
+    return index(minMax.first, minMax.second - 1);
+}
+
+int ChordMatrixModel::cellIndex(int row, int col) const
+{
+    // row is chord i, column is chord j=col+1, only i<j is stored
+    int n = chordList.length(), i = row, j = col + 1;
+    if (i >= j || j >= n)
+        return -1;
+    return i * n - i * (i + 1) / 2 + (j - i - 1);
+}
+
+ChordMatrixModel::Cell ChordMatrixModel::cellFor(int chord1_id, int chord2_id,
+                                                 const QHash<QPair<int, int>, ChordPair> &pairs) const
+{
+    // pairs without counts might not be stored
+    auto it = pairs.constFind(qMakePair(chord1_id, chord2_id));
+    if (it == pairs.constEnd())
+        return Cell{-1, -1};
+    return Cell{it.value().id, it.value().latest_count};
+}
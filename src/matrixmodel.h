@@ -0,0 +1,57 @@
+#ifndef MATRIXMODEL_H
+#define MATRIXMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QVector>
+#include "colorscale.h"
+#include "models.h"
+
+
+class ChordMatrixModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    ChordMatrixModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    void setMatrix(const QList<Chord> &chords, const QHash<QPair<int, int>, ChordPair> &pairs);
+    void updatePair(const ChordPair &pair);
+
+    ChordPair pair(const QModelIndex &index) const;
+    QModelIndex indexOf(int chord1_id, int chord2_id) const;
+    const QList<Chord> &chords() const { return chordList; }
+
+    const ColorScale &colorScale() const { return scale; }
+    void setColorScale(const ColorScale &colorScale);
+
+private:
+    // summary of a single cell in the upper triangle
+    struct Cell
+    {
+        int pair_id;
+        int latest_count;
+        bool operator==(const Cell &other) const
+        { return pair_id == other.pair_id && latest_count == other.latest_count; }
+    };
+
+    int cellIndex(int row, int col) const;
+    Cell cellFor(int chord1_id, int chord2_id, const QHash<QPair<int, int>, ChordPair> &pairs) const;
+
+    QList<Chord> chordList;
+    QHash<int, int> chordIndex;
+
+    // cells of upper triangle, row by row
+    QVector<Cell> cells;
+
+    // shading of cells by count
+    ColorScale scale;
+};
+
+#endif // MATRIXMODEL_H
@@ -0,0 +1,137 @@
+#include "metronome.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef OMC_HAVE_AUDIO
+#include <QAudioFormat>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <QAudioSink>
+#include <QMediaDevices>
+#else
+#include <QAudioOutput>
+#endif
+#endif
+
+// audio output buffer (~20 ms) and refill interval
+static const int OUTPUT_FRAMES = 960;
+static const int FILL_INTERVAL = 10;
+
+RingDevice::RingDevice(RingBuffer *ring, QObject *parent)
+    : QIODevice(parent), ring(ring), underrun(0)
+{
+
+}
+
+qint64 RingDevice::readData(char *data, qint64 maxSize)
+{
+    // whole frames from ring
+    int count = int(maxSize / sizeof(qint16));
+    auto samples = reinterpret_cast<qint16*>(data);
+    int read = ring->read(samples, count);
+
+    // pad with silence instead of stalling the output, producer skips the same amount to stay in sync
+    if (read < count) {
+        std::memset(samples + read, 0, (count - read) * sizeof(qint16));
+        underrun += count - read;
+    }
+    return count * qint64(sizeof(qint16));
+}
+
+qint64 RingDevice::writeData(const char *, qint64)
+{
+    return -1;
+}
+
+Metronome::Metronome(QObject *parent)
+    : QObject(parent), track(nullptr), ring(ClickTrack::RING_FRAMES), device(&ring), rendered(0)
+{
+#ifdef OMC_HAVE_AUDIO
+    // 16 bit mono output
+    QAudioFormat format;
+    format.setSampleRate(ClickTrack::SAMPLE_RATE);
+    format.setChannelCount(1);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    format.setSampleFormat(QAudioFormat::Int16);
+    output = new QAudioSink(QMediaDevices::defaultAudioOutput(), format, this);
+#else
+    format.setSampleSize(16);
+    format.setCodec("audio/pcm");
+    format.setByteOrder(QAudioFormat::LittleEndian);
+    format.setSampleType(QAudioFormat::SignedInt);
+    output = new QAudioOutput(format, this);
+#endif
+    output->setBufferSize(OUTPUT_FRAMES * sizeof(qint16));
+#endif
+
+    // keep ring filled
+    fillTimer.setTimerType(Qt::PreciseTimer);
+    fillTimer.setInterval(FILL_INTERVAL);
+    connect(&fillTimer, &QTimer::timeout, this, &Metronome::fill);
+}
+
+Metronome::~Metronome()
+{
+    stop();
+}
+
+bool Metronome::isAvailable()
+{
+#ifdef OMC_HAVE_AUDIO
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Metronome::start(double bpm)
+{
+    // without audio output there's nothing to do
+    stop();
+    if (!isAvailable())
+        return;
+
+    // render beginning of session before output starts, so that sample 0 is the session start
+    track = new ClickTrack(ClickTrack::SAMPLE_RATE, bpm);
+    ring.clear();
+    rendered = 0;
+    device.takeUnderrun();
+    fill();
+
+    // start pulling
+    device.open(QIODevice::ReadOnly);
+#ifdef OMC_HAVE_AUDIO
+    output->start(&device);
+#endif
+    fillTimer.start();
+}
+
+void Metronome::stop()
+{
+    // stop output and producer
+    fillTimer.stop();
+#ifdef OMC_HAVE_AUDIO
+    output->stop();
+#endif
+    device.close();
+    delete track;
+    track = nullptr;
+}
+
+void Metronome::fill()
+{
+    // session over?
+    if (!track)
+        return;
+
+    // skip frames the output has padded with silence, so that clicks stay on their samples
+    rendered += device.takeUnderrun();
+
+    // render as much as fits
+    QVector<qint16> chunk(ring.space());
+    int count = int(std::min<qint64>(chunk.size(), std::max<qint64>(track->length() - rendered, 0)));
+    if (count > 0) {
+        track->render(chunk.data(), rendered, count);
+        rendered += ring.write(chunk.constData(), count);
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef METRONOME_H
+#define METRONOME_H
+
+#include <QIODevice>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <atomic>
+#include "clicktrack.h"
+
+#ifdef OMC_HAVE_AUDIO
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+class QAudioSink;
+#else
+class QAudioOutput;
+#endif
+#endif
+
+
+// device the audio output pulls from, pads with silence if the buffer runs dry
+class RingDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    RingDevice(RingBuffer *ring, QObject *parent = nullptr);
+
+    // number of frames padded since last call
+    qint64 takeUnderrun() { return underrun.exchange(0); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    RingBuffer *ring;
+    std::atomic<qint64> underrun;
+};
+
+class Metronome : public QObject
+{
+    Q_OBJECT
+
+public:
+    Metronome(QObject *parent = nullptr);
+    ~Metronome();
+
+    static bool isAvailable();
+    void start(double bpm);
+    void stop();
+
+private slots:
+    void fill();
+
+private:
+    ClickTrack *track;
+    RingBuffer ring;
+    RingDevice device;
+    QTimer fillTimer;
+
+    // frames of the session rendered into the ring so far
+    qint64 rendered;
+
+#ifdef OMC_HAVE_AUDIO
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    QAudioSink *output;
+#else
+    QAudioOutput *output;
+#endif
+#endif
+};
+
+#endif // METRONOME_H
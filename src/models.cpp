@@ -1,9 +1,156 @@
 #include "models.h"
+#include "analytics.h"
+#include "database.h"
 
+#include <QMutex>
 #include <QSqlQuery>
 #include <QVariant>
 #include <QDebug>
 
+// columns for reading a full chord pair including its summary
+#define CHORDPAIR_COLUMNS "id, chord1_id, chord2_id, latest_count, latest_time, sessions"
+
+static ChordPair chordPairFromQuery(const QSqlQuery &query)
+{
+    // latest count is NULL for pairs that have never been practised
+    return ChordPair(query.value(0).toInt(), query.value(1).toInt(), query.value(2).toInt(),
+                     query.value(3).isNull() ? -1 : query.value(3).toInt(),
+                     query.value(4).toLongLong(), query.value(5).toInt());
+}
+
+// process-wide identity map for chords and chord pairs, so that repeated lookups are hash hits,
+// shared between GUI and worker thread
+namespace {
+class Cache
+{
+public:
+    bool findChordId(const QString &name, int *id)
+    {
+        QMutexLocker locker(&mutex);
+        auto it = chordIds.constFind(name);
+        if (it == chordIds.constEnd())
+            return false;
+        *id = it.value();
+        return true;
+    }
+
+    bool findChord(int id, Chord *chord)
+    {
+        QMutexLocker locker(&mutex);
+        auto it = chords.constFind(id);
+        if (it == chords.constEnd())
+            return false;
+        *chord = it.value();
+        return true;
+    }
+
+    void insertChord(const Chord &chord)
+    {
+        QMutexLocker locker(&mutex);
+        chords.insert(chord.id, chord);
+        chordIds.insert(chord.name, chord.id);
+    }
+
+    void removeChord(int id, const QString &name)
+    {
+        QMutexLocker locker(&mutex);
+        chords.remove(id);
+        chordIds.remove(name);
+
+        // pairs with the chord are gone as well
+        for (auto it = pairs.begin(); it != pairs.end();) {
+            if (it.key().first == id || it.key().second == id) {
+                pairKeys.remove(it.value().id);
+                it = pairs.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    bool findPair(int chord1_id, int chord2_id, ChordPair *pair)
+    {
+        // if all pairs are cached, a missing one is known to be virtual
+        QMutexLocker locker(&mutex);
+        auto it = pairs.constFind(qMakePair(chord1_id, chord2_id));
+        if (it != pairs.constEnd())
+            *pair = it.value();
+        else if (allPairs)
+            *pair = ChordPair(-1, chord1_id, chord2_id);
+        else
+            return false;
+        return true;
+    }
+
+    bool findPairById(int id, ChordPair *pair)
+    {
+        QMutexLocker locker(&mutex);
+        auto it = pairKeys.constFind(id);
+        if (it == pairKeys.constEnd())
+            return false;
+        *pair = pairs.value(it.value(), ChordPair::empty());
+        return true;
+    }
+
+    void insertPair(const ChordPair &pair)
+    {
+        QMutexLocker locker(&mutex);
+        auto key = qMakePair(pair.chord1_id, pair.chord2_id);
+        pairs.insert(key, pair);
+        if (pair.exists())
+            pairKeys.insert(pair.id, key);
+    }
+
+    void replacePairs(const QHash<QPair<int, int>, ChordPair> &all)
+    {
+        // now we know all stored pairs
+        QMutexLocker locker(&mutex);
+        pairs = all;
+        pairKeys.clear();
+        for (auto it = all.constBegin(); it != all.constEnd(); ++it)
+            pairKeys.insert(it.value().id, it.key());
+        allPairs = true;
+    }
+
+private:
+    QMutex mutex;
+
+    // chords by id and ids by name
+    QHash<int, Chord> chords;
+    QHash<QString, int> chordIds;
+
+    // pairs by their chord ids, including virtual ones, and keys by pair id
+    QHash<QPair<int, int>, ChordPair> pairs;
+    QHash<int, QPair<int, int>> pairKeys;
+
+    // whether all stored pairs are in the cache
+    bool allPairs = false;
+};
+}
+
+static Cache cache;
+
+static ChordPair queryPairById(int id)
+{
+    // fetch pair from database
+    Statement query("SELECT " CHORDPAIR_COLUMNS " FROM chordpair WHERE id=:id");
+    query->bindValue(":id", id);
+    if (query->exec() && query->first()) {
+        // found it
+        return chordPairFromQuery(*query);
+    }
+    return ChordPair::empty();
+}
+
+static void reloadPair(int id)
+{
+    // update summary of pair in cache after its counts changed
+    auto pair = queryPairById(id);
+    if (pair.exists())
+        cache.insertPair(pair);
+}
+
 Chord::Chord(int id, const QString &name) : id(id), name(name)
 {
 
@@ -13,10 +160,11 @@ const QList<Chord> Chord::list()
 {
     // get all chord names
     QList<Chord> chords;
-    QSqlQuery query;
-    if (query.exec("SELECT id, name FROM chord ORDER BY name")) {
-        while(query.next()) {
-            Chord chord(query.value(0).toInt(), query.value(1).toString());
+    Statement query("SELECT id, name FROM chord ORDER BY name");
+    if (query->exec()) {
+        while(query->next()) {
+            Chord chord(query->value(0).toInt(), query->value(1).toString());
+            cache.insertChord(chord);
             chords.append(chord);
         }
     }
@@ -25,42 +173,77 @@ const QList<Chord> Chord::list()
 
 const Chord Chord::getOrCreate(QString name)
 {
+    // in cache?
+    int id;
+    if (cache.findChordId(name, &id))
+        return Chord(id, name);
+
+    // lookup and insert in one go
+    Transaction transaction;
+
     // try to find it
-    QSqlQuery query;
-    query.prepare("SELECT id FROM chord WHERE name=:name");
-    query.bindValue(":name", name);
-    if (query.exec() && query.first()) {
+    Statement query("SELECT id FROM chord WHERE name=:name");
+    query->bindValue(":name", name);
+    if (query->exec() && query->first()) {
         // found it
-        return Chord(query.value(0).toInt(), name);
+        transaction.commit();
+        Chord chord(query->value(0).toInt(), name);
+        cache.insertChord(chord);
+        return chord;
     }
 
     // couldn't find it, create new one
-    query.prepare("INSERT INTO chord (name) VALUES (:name)");
-    query.bindValue(":name", name);
-    query.exec();
-    return Chord(query.lastInsertId().toInt(), name);
+    Statement insert("INSERT INTO chord (name) VALUES (:name)");
+    insert->bindValue(":name", name);
+    if (insert->exec() && transaction.commit()) {
+        Chord chord(insert->lastInsertId().toInt(), name);
+        cache.insertChord(chord);
+        return chord;
+    }
+    return Chord::empty();
 }
 
 const Chord Chord::getById(int id)
 {
+    // in cache?
+    auto chord = Chord::empty();
+    if (cache.findChord(id, &chord))
+        return chord;
+
     // try to find it
-    QSqlQuery query;
-    query.prepare("SELECT name FROM chord WHERE id=:id");
-    query.bindValue(":id", id);
-    if (query.exec() && query.first()) {
+    Statement query("SELECT name FROM chord WHERE id=:id");
+    query->bindValue(":id", id);
+    if (query->exec() && query->first()) {
         // found it
-        return Chord(id, query.value(0).toString());
+        chord = Chord(id, query->value(0).toString());
+        cache.insertChord(chord);
+        return chord;
     }
     return Chord::empty();
 }
 
 bool Chord::remove(QString name)
 {
+    // lookup and delete in one go
+    Transaction transaction;
+
     // try to find it
-    QSqlQuery query;
-    query.prepare("DELETE FROM chord WHERE name=:name");
-    query.bindValue(":name", name);
-    return query.exec();
+    Statement query("SELECT id FROM chord WHERE name=:name");
+    query->bindValue(":name", name);
+    if (!query->exec() || !query->first())
+        return false;
+    int id = query->value(0).toInt();
+    query->finish();
+
+    // delete it
+    Statement remove("DELETE FROM chord WHERE id=:id");
+    remove->bindValue(":id", id);
+    if (!remove->exec())
+        return false;
+
+    // forget chord and its pairs, once committed
+    Transaction::afterCommit([id, name]() { cache.removeChord(id, name); });
+    return transaction.commit();
 }
 
 const Chord Chord::empty()
@@ -68,13 +251,18 @@ const Chord Chord::empty()
     return Chord(-1, "");
 }
 
-ChordPair::ChordPair(int id, int chord1_id, int chord2_id) : id(id), chord1_id(chord1_id), chord2_id(chord2_id)
+ChordPair::ChordPair(int id, int chord1_id, int chord2_id, int latest_count, qint64 latest_time, int sessions)
+    : id(id), chord1_id(chord1_id), chord2_id(chord2_id),
+      latest_count(latest_count), sessions(sessions), latest_time(latest_time)
 {
 
 }
 
 const QList<ChordCount> ChordPair::counts()
 {
+    // pairs that are not stored yet have no counts
+    if (!exists())
+        return QList<ChordCount>();
     return ChordCount::listForPair(id);
 }
 
@@ -85,40 +273,94 @@ const ChordPair ChordPair::empty()
 
 const ChordPair ChordPair::getById(int id)
 {
+    // in cache?
+    auto pair = ChordPair::empty();
+    if (cache.findPairById(id, &pair))
+        return pair;
+
     // try to find it
-    QSqlQuery query;
-    query.prepare("SELECT chord1_id, chord2_id FROM chordpair WHERE id=:id");
-    query.bindValue(":id", id);
-    if (query.exec() && query.first()) {
-        // found it
-        return ChordPair(id, query.value(0).toInt(), query.value(1).toInt());
-    }
-    return ChordPair::empty();
+    pair = queryPairById(id);
+    if (pair.exists())
+        cache.insertPair(pair);
+    return pair;
 }
 
-const ChordPair ChordPair::getOrCreate(int chord1_id, int chord2_id)
+const ChordPair ChordPair::get(int chord1_id, int chord2_id)
 {
+    // in cache?
+    auto cached = ChordPair::empty();
+    if (cache.findPair(chord1_id, chord2_id, &cached))
+        return cached;
+
     // try to find it
-    QSqlQuery query;
-    query.prepare("SELECT id FROM chordpair WHERE chord1_id=:id1 AND chord2_id=:id2");
-    query.bindValue(":id1", chord1_id);
-    query.bindValue(":id2", chord2_id);
-    if (query.exec() && query.first()) {
+    Statement query("SELECT " CHORDPAIR_COLUMNS " FROM chordpair WHERE chord1_id=:id1 AND chord2_id=:id2");
+    query->bindValue(":id1", chord1_id);
+    query->bindValue(":id2", chord2_id);
+    if (query->exec() && query->first()) {
         // found it
-        return ChordPair(query.value(0).toInt(), chord1_id, chord2_id);
+        auto pair = chordPairFromQuery(*query);
+        cache.insertPair(pair);
+        return pair;
     }
 
-    // couldn't find it, create new one
-    query.prepare("INSERT INTO chordpair (chord1_id, chord2_id) VALUES (:id1, :id2)");
-    query.bindValue(":id1", chord1_id);
-    query.bindValue(":id2", chord2_id);
-    if (query.exec()) {
-        return ChordPair(query.lastInsertId().toInt(), chord1_id, chord2_id);
+    // not stored yet, so return a virtual pair without id and remember it
+    ChordPair pair(-1, chord1_id, chord2_id);
+    cache.insertPair(pair);
+    return pair;
+}
+
+const ChordPair ChordPair::getOrCreate(int chord1_id, int chord2_id)
+{
+    // stored pairs can come from cache, but a virtual one may have been stored by another process since
+    auto cached = ChordPair::empty();
+    if (cache.findPair(chord1_id, chord2_id, &cached) && cached.exists())
+        return cached;
+
+    // insert and lookup in one go
+    Transaction transaction;
+
+    // create it, unless it exists already
+    Statement insert("INSERT OR IGNORE INTO chordpair (chord1_id, chord2_id) VALUES (:id1, :id2)");
+    insert->bindValue(":id1", chord1_id);
+    insert->bindValue(":id2", chord2_id);
+    if (!insert->exec())
+        return ChordPair::empty();
+    insert->finish();
+
+    // fetch it, new or not
+    Statement query("SELECT " CHORDPAIR_COLUMNS " FROM chordpair WHERE chord1_id=:id1 AND chord2_id=:id2");
+    query->bindValue(":id1", chord1_id);
+    query->bindValue(":id2", chord2_id);
+    if (!query->exec() || !query->first())
+        return ChordPair::empty();
+    auto pair = chordPairFromQuery(*query);
+    query->finish();
+
+    // replace virtual pair in cache, once committed
+    Transaction::afterCommit([pair]() { cache.insertPair(pair); });
+    if (!transaction.commit())
+        return ChordPair::empty();
+    return pair;
+}
+
+const QHash<QPair<int, int>, ChordPair> ChordPair::matrix()
+{
+    // get all pairs with their summaries, which are kept up to date by triggers on chordcount
+    QHash<QPair<int, int>, ChordPair> pairs;
+    Statement query("SELECT " CHORDPAIR_COLUMNS " FROM chordpair");
+    if (query->exec()) {
+        while(query->next()) {
+            ChordPair pair = chordPairFromQuery(*query);
+            pairs.insert(qMakePair(pair.chord1_id, pair.chord2_id), pair);
+        }
+
+        // replace cache, which now knows all stored pairs
+        cache.replacePairs(pairs);
     }
-    return ChordPair::empty();
+    return pairs;
 }
 
-ChordCount::ChordCount(int id, int chords_id, QDateTime time, int count) : id(id), chords_id(chords_id), count(count), time(time)
+ChordCount::ChordCount(int id, int chords_id, qint64 time, int count) : id(id), chords_id(chords_id), count(count), time(time)
 {
 
 }
@@ -127,12 +369,32 @@ const QList<ChordCount> ChordCount::listForPair(int pair_id)
 {
     // get all counts for pair
     QList<ChordCount> counts;
-    QSqlQuery query;
-    query.prepare("SELECT id, time, count FROM chordcount WHERE chords_id=:id ORDER BY time ASC");
-    query.bindValue(":id", pair_id);
-    if (query.exec()) {
-        while(query.next()) {
-            ChordCount count(query.value(0).toInt(), pair_id, query.value(1).toDateTime(), query.value(2).toInt());
+    Statement query("SELECT id, time, count FROM chordcount WHERE chords_id=:id ORDER BY time ASC");
+    query->bindValue(":id", pair_id);
+    if (query->exec()) {
+        while(query->next()) {
+            ChordCount count(query->value(0).toInt(), pair_id, query->value(1).toLongLong(), query->value(2).toInt());
+            counts.append(count);
+        }
+    }
+    return counts;
+}
+
+const QList<ChordCount> ChordCount::pageForPair(int pair_id, qint64 before_time, int before_id, int limit)
+{
+    // get counts for pair, newest first, that are older than the given one, using (chords_id, time) index
+    QList<ChordCount> counts;
+    Statement query("SELECT id, time, count FROM chordcount "
+                    "WHERE chords_id=:id AND (time<:time1 OR (time=:time2 AND id<:count_id)) "
+                    "ORDER BY time DESC, id DESC LIMIT :limit");
+    query->bindValue(":id", pair_id);
+    query->bindValue(":time1", before_time);
+    query->bindValue(":time2", before_time);
+    query->bindValue(":count_id", before_id);
+    query->bindValue(":limit", limit);
+    if (query->exec()) {
+        while(query->next()) {
+            ChordCount count(query->value(0).toInt(), pair_id, query->value(1).toLongLong(), query->value(2).toInt());
             counts.append(count);
         }
     }
@@ -142,21 +404,46 @@ const QList<ChordCount> ChordCount::listForPair(int pair_id)
 ChordCount ChordCount::create(int pair_id, int count)
 {
     // create count
-    QSqlQuery query;
-    query.prepare("INSERT INTO chordcount (chords_id, time, count) VALUES (:id, :time, :count)");
-    query.bindValue(":id", pair_id);
-    auto time = QDateTime::currentDateTime();
-    query.bindValue(":time", time);
-    query.bindValue(":count", count);
-    query.exec();
-    return ChordCount(query.lastInsertId().toInt(), pair_id, time, count);
+    Statement query("INSERT INTO chordcount (chords_id, time, count) VALUES (:id, :time, :count)");
+    query->bindValue(":id", pair_id);
+    auto time = QDateTime::currentMSecsSinceEpoch();
+    query->bindValue(":time", time);
+    query->bindValue(":count", count);
+    if (pair_id < 0 || !query->exec())
+        return ChordCount(-1, pair_id, time, count);
+    ChordCount created(query->lastInsertId().toInt(), pair_id, time, count);
+
+    // summary of pair has been changed by trigger, but only counts once committed
+    Transaction::afterCommit([created]() {
+        reloadPair(created.chords_id);
+        Analytics::countAdded(created);
+    });
+    return created;
 }
 
 bool ChordCount::remove(int id)
 {
+    // lookup and delete in one go
+    Transaction transaction;
+
+    // get pair, whose summary will change
+    Statement query("SELECT chords_id, time, count FROM chordcount WHERE id=:id");
+    query->bindValue(":id", id);
+    if (!query->exec() || !query->first())
+        return false;
+    ChordCount removed(id, query->value(0).toInt(), query->value(1).toLongLong(), query->value(2).toInt());
+    query->finish();
+
     // try to find it
-    QSqlQuery query;
-    query.prepare("DELETE FROM chordcount WHERE id=:id");
-    query.bindValue(":id", id);
-    return query.exec();
+    Statement remove("DELETE FROM chordcount WHERE id=:id");
+    remove->bindValue(":id", id);
+    if (!remove->exec() || remove->numRowsAffected() < 1)
+        return false;
+
+    // update pair in cache, once committed
+    Transaction::afterCommit([removed]() {
+        reloadPair(removed.chords_id);
+        Analytics::countRemoved(removed);
+    });
+    return transaction.commit();
 }
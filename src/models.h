@@ -2,7 +2,9 @@
 #define MODELS_H
 
 #include <QDateTime>
+#include <QHash>
 #include <QList>
+#include <QPair>
 #include <QString>
 
 
@@ -27,31 +29,41 @@ public:
 class ChordPair
 {
 public:
-    ChordPair(int id, int chord1_id, int chord2_id);
+    ChordPair(int id, int chord1_id, int chord2_id,
+              int latest_count = -1, qint64 latest_time = 0, int sessions = 0);
 
-    inline bool isEmpty() { return id == -1; };
+    inline bool isEmpty() const { return chord1_id == -1; };
+    inline bool exists() const { return id != -1; };
     const QList<ChordCount> counts();
     inline Chord chord1() { return Chord::getById(chord1_id); }
     inline Chord chord2() { return Chord::getById(chord2_id); }
 
     static const ChordPair empty();
     static const ChordPair getById(int id);
+    static const ChordPair get(int chord1_id, int chord2_id);
     static const ChordPair getOrCreate(int chord1_id, int chord2_id);
+    static const QHash<QPair<int, int>, ChordPair> matrix();
 
     int id, chord1_id, chord2_id;
+    int latest_count, sessions;
+    qint64 latest_time;
 };
 
 class ChordCount
 {
 public:
-    ChordCount(int id, int chords_id, QDateTime time, int count);
+    ChordCount(int id, int chords_id, qint64 time, int count);
+
+    inline bool exists() const { return id != -1; };
+    inline QDateTime dateTime() const { return QDateTime::fromMSecsSinceEpoch(time); }
 
     static const QList<ChordCount> listForPair(int pair_id);
+    static const QList<ChordCount> pageForPair(int pair_id, qint64 before_time, int before_id, int limit);
     static ChordCount create(int pair_id, int count);
     static bool remove(int id);
 
     int id, chords_id, count;
-    QDateTime time;
+    qint64 time;    // milliseconds since epoch
 };
 
 #endif // MODELS_H
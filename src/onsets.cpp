@@ -0,0 +1,190 @@
+#include "onsets.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// number of independent accumulators in reductions, see stats.cpp
+static const int LANES = 4;
+
+static const double PI = 3.14159265358979323846;
+
+// compression of magnitudes, so that quiet strums still show
+static const float COMPRESSION = 100.f;
+
+// frames before and after a candidate for local maximum and mean, threshold above mean,
+// and minimum time between two onsets in seconds
+static const int MAX_BEFORE = 3, MAX_AFTER = 3, MEAN_BEFORE = 10, MEAN_AFTER = 3;
+static const float DELTA = 0.1f;
+static const double MIN_INTERVAL = 0.1;
+
+OnsetDetector::OnsetDetector(int sampleRate, int frameSize, int hopSize)
+    : rate(sampleRate), size(frameSize), hop(hopSize), filled(0), decided(0), lastOnset(-1)
+{
+    // frame size must be a power of two for the FFT
+    int bits = 0;
+    while ((1 << bits) < size)
+        bits++;
+    size = 1 << bits;
+
+    // hann window
+    window.resize(size);
+    for (int i = 0; i < size; ++i)
+        window[i] = float(0.5 - 0.5 * std::cos(2. * PI * i / size));
+
+    // bit reversal permutation
+    reverse.resize(size);
+    for (int i = 0; i < size; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        reverse[i] = r;
+    }
+
+    // twiddle factors for the largest stage, smaller stages use every k-th one
+    cosTable.resize(size / 2);
+    sinTable.resize(size / 2);
+    for (int i = 0; i < size / 2; ++i) {
+        cosTable[i] = float(std::cos(2. * PI * i / size));
+        sinTable[i] = float(-std::sin(2. * PI * i / size));
+    }
+
+    // buffers
+    input.resize(size);
+    re.resize(size);
+    im.resize(size);
+    magnitude.assign(size / 2, 0.f);
+    previous.assign(size / 2, 0.f);
+}
+
+void OnsetDetector::process(const float *samples, int n)
+{
+    while (n > 0) {
+        // fill frame
+        int count = std::min(n, size - filled);
+        std::memcpy(input.data() + filled, samples, count * sizeof(float));
+        filled += count;
+        samples += count;
+        n -= count;
+
+        // analyse full frame and move on by one hop
+        if (filled == size) {
+            analyseFrame();
+            std::memmove(input.data(), input.data() + hop, (size - hop) * sizeof(float));
+            filled = size - hop;
+        }
+    }
+
+    // check all frames that have enough context by now
+    pickPeaks(false);
+}
+
+void OnsetDetector::finish()
+{
+    // check remaining frames with what is there
+    pickPeaks(true);
+}
+
+int OnsetDetector::count(double from, double to) const
+{
+    // onsets in time range
+    return int(std::lower_bound(times.begin(), times.end(), to) - std::lower_bound(times.begin(), times.end(), from));
+}
+
+int OnsetDetector::changes(double duration) const
+{
+    // session starts with first strum, which is the starting chord, and every further one is a change
+    if (times.empty())
+        return 0;
+    return std::max(count(times.front(), times.front() + duration) - 1, 0);
+}
+
+void OnsetDetector::analyseFrame()
+{
+    // window, in bit reversed order for the in-place FFT
+    const float *in = input.data(), *w = window.data();
+    for (int i = 0; i < size; ++i) {
+        re[reverse[i]] = in[i] * w[i];
+        im[reverse[i]] = 0.f;
+    }
+    fft();
+
+    // compressed magnitudes of the lower half
+    int bins = size / 2;
+    const float *r = re.data(), *m = im.data();
+    float *mag = magnitude.data();
+    for (int k = 0; k < bins; ++k)
+        mag[k] = std::log1p(COMPRESSION * std::sqrt(r[k] * r[k] + m[k] * m[k]));
+
+    // sum of increases only, in lanes
+    const float *prev = previous.data();
+    float sum[LANES] = {0.f, 0.f, 0.f, 0.f};
+    int k = 0;
+    for (; k + LANES <= bins; k += LANES) {
+        for (int l = 0; l < LANES; ++l)
+            sum[l] += std::max(mag[k + l] - prev[k + l], 0.f);
+    }
+    for (; k < bins; ++k)
+        sum[0] += std::max(mag[k] - prev[k], 0.f);
+    // the first frame has nothing to compare with
+    flux.push_back(flux.empty() ? 0.f : (sum[0] + sum[1] + sum[2] + sum[3]) / bins);
+
+    // keep for next frame
+    std::swap(magnitude, previous);
+}
+
+void OnsetDetector::pickPeaks(bool final)
+{
+    // frames with enough frames after them, or all at the end
+    int n = int(flux.size());
+    int last = final ? n : n - std::max(MAX_AFTER, MEAN_AFTER);
+    int minFrames = int(std::ceil(MIN_INTERVAL * rate / hop));
+    for (; decided < last; ++decided) {
+        int t = decided;
+
+        // local maximum?
+        bool peak = true;
+        for (int i = std::max(t - MAX_BEFORE, 0); peak && i <= std::min(t + MAX_AFTER, n - 1); ++i)
+            peak = flux[i] <= flux[t];
+        if (!peak)
+            continue;
+
+        // above local mean?
+        int from = std::max(t - MEAN_BEFORE, 0), to = std::min(t + MEAN_AFTER, n - 1);
+        float mean = 0.f;
+        for (int i = from; i <= to; ++i)
+            mean += flux[i];
+        mean /= to - from + 1;
+        if (flux[t] < mean + DELTA)
+            continue;
+
+        // not too close to last one?
+        if (lastOnset >= 0 && t - lastOnset < minFrames)
+            continue;
+
+        // onset at centre of frame
+        lastOnset = t;
+        times.push_back((double(t) * hop + size / 2.) / rate);
+    }
+}
+
+void OnsetDetector::fft()
+{
+    // iterative radix 2 on bit reversed input, inner loops run over independent butterflies
+    float *r = re.data(), *m = im.data();
+    const float *c = cosTable.data(), *s = sinTable.data();
+    for (int len = 2; len <= size; len <<= 1) {
+        int half = len / 2, step = size / len;
+        for (int start = 0; start < size; start += len) {
+            float *r0 = r + start, *m0 = m + start, *r1 = r0 + half, *m1 = m0 + half;
+            for (int j = 0; j < half; ++j) {
+                float wr = c[j * step], wi = s[j * step];
+                float tr = r1[j] * wr - m1[j] * wi, ti = r1[j] * wi + m1[j] * wr;
+                r1[j] = r0[j] - tr;
+                m1[j] = m0[j] - ti;
+                r0[j] += tr;
+                m0[j] += ti;
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef ONSETS_H
+#define ONSETS_H
+
+#include <vector>
+
+
+// streaming onset detection by spectral flux, fed with mono samples in arbitrary chunks
+class OnsetDetector
+{
+public:
+    OnsetDetector(int sampleRate, int frameSize = 1024, int hopSize = 512);
+
+    void process(const float *samples, int n);
+    void finish();
+
+    const std::vector<double> &onsets() const { return times; }
+    int count(double from, double to) const;
+    int changes(double duration) const;
+
+private:
+    void analyseFrame();
+    void pickPeaks(bool final);
+    void fft();
+
+    int rate, size, hop;
+
+    // window, bit reversal and twiddle tables, computed once
+    std::vector<float> window, cosTable, sinTable;
+    std::vector<int> reverse;
+
+    // samples of current frame, and how many of them are there
+    std::vector<float> input;
+    int filled;
+
+    // spectrum of current frame, and compressed magnitudes of current and previous one
+    std::vector<float> re, im, magnitude, previous;
+
+    // flux of all frames so far, and number of frames that have been checked for peaks
+    std::vector<float> flux;
+    int decided, lastOnset;
+
+    // onset times in seconds
+    std::vector<double> times;
+};
+
+#endif // ONSETS_H
@@ -0,0 +1,146 @@
+#include "recommender.h"
+
+#include <QDateTime>
+#include <algorithm>
+#include <cmath>
+
+// count that is considered mastered, and number of days after which a pair is stale
+static const double TARGET = 60.;
+static const double STALE_DAYS = 7.;
+
+// scores are only comparable for the same time, so they get recomputed after this
+static const qint64 RESCORE_INTERVAL = 3600000;
+
+Recommender::Recommender()
+    : now(0)
+{
+
+}
+
+void Recommender::setPairs(const QList<Chord> &chords, const QHash<QPair<int, int>, ChordPair> &pairs)
+{
+    // all combinations of chords, stored or not
+    heap.clear();
+    for (int i = 0; i < chords.length(); ++i) {
+        for (int j = i + 1; j < chords.length(); ++j) {
+            auto minMaxIds = std::minmax({chords[i].id, chords[j].id});
+            auto key = qMakePair(minMaxIds.first, minMaxIds.second);
+            auto pair = pairs.value(key, ChordPair(-1, key.first, key.second));
+            heap.append(Entry{key.first, key.second, pair.id, pair.latest_count, pair.latest_time, 0., 0.});
+        }
+    }
+
+    // score and heapify
+    rescore();
+}
+
+void Recommender::update(const ChordPair &pair, const PairStats &stats)
+{
+    // unknown pair?
+    auto minMaxIds = std::minmax({pair.chord1_id, pair.chord2_id});
+    auto it = position.constFind(qMakePair(minMaxIds.first, minMaxIds.second));
+    if (it == position.constEnd())
+        return;
+
+    // change entry and restore heap order
+    int i = it.value();
+    auto &entry = heap[i];
+    double old = entry.score;
+    entry.pair_id = pair.id;
+    entry.latest_count = pair.latest_count;
+    entry.latest_time = pair.latest_time;
+    entry.slope = stats.sessions > 0 ? stats.slope : 0.;
+    entry.score = score(entry);
+    if (entry.score > old)
+        siftUp(i);
+    else
+        siftDown(i);
+}
+
+void Recommender::rescore()
+{
+    // score everything for current time, with slopes taken from analytics in one go
+    now = QDateTime::currentMSecsSinceEpoch();
+    auto slopes = Analytics::slopes();
+    position.clear();
+    for (int i = 0; i < heap.size(); ++i) {
+        heap[i].slope = slopes.value(heap[i].pair_id, 0.);
+        heap[i].score = score(heap[i]);
+        position.insert(qMakePair(heap[i].chord1_id, heap[i].chord2_id), i);
+    }
+
+    // bottom-up heap construction, swaps keep positions up to date
+    for (int i = heap.size() / 2 - 1; i >= 0; --i)
+        siftDown(i);
+}
+
+ChordPair Recommender::next(const ChordPair &current)
+{
+    // scores too old?
+    if (QDateTime::currentMSecsSinceEpoch() - now > RESCORE_INTERVAL)
+        rescore();
+    if (heap.isEmpty())
+        return ChordPair::empty();
+
+    // best pair, or the better of its children if it is the current one
+    int best = 0;
+    if (heap[0].chord1_id == current.chord1_id && heap[0].chord2_id == current.chord2_id) {
+        if (heap.size() == 1)
+            return ChordPair::empty();
+        best = heap.size() > 2 && heap[2].score > heap[1].score ? 2 : 1;
+    }
+    const auto &entry = heap[best];
+    return ChordPair(entry.pair_id, entry.chord1_id, entry.chord2_id, entry.latest_count, entry.latest_time);
+}
+
+double Recommender::score(const Entry &entry) const
+{
+    // how far the latest count is from the target, never practised counts as zero
+    double deficit = std::min(std::max((TARGET - std::max(entry.latest_count, 0)) / TARGET, 0.), 1.);
+
+    // approaches 1 the longer a pair hasn't been practised
+    double staleness = entry.latest_time > 0 ? 1. - std::exp(-(now - entry.latest_time) / 86400000. / STALE_DAYS) : 1.;
+
+    // 1 for pairs that don't improve, 0.5 for those that gain one change per day
+    double stagnation = 1. / (1. + std::max(entry.slope, 0.));
+
+    // weighted sum
+    return 0.5 * deficit + 0.3 * staleness + 0.2 * stagnation;
+}
+
+void Recommender::siftUp(int i)
+{
+    // move up while better than parent
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap[parent].score >= heap[i].score)
+            break;
+        swap(i, parent);
+        i = parent;
+    }
+}
+
+void Recommender::siftDown(int i)
+{
+    // move down while worse than a child
+    int n = heap.size();
+    while (true) {
+        int best = i, left = 2 * i + 1, right = left + 1;
+        if (left < n && heap[left].score > heap[best].score)
+            best = left;
+        if (right < n && heap[right].score > heap[best].score)
+            best = right;
+        if (best == i)
+            break;
+        swap(i, best);
+        i = best;
+    }
+}
+
+void Recommender::swap(int i, int j)
+{
+    // swap entries and keep track of their positions
+    std::swap(heap[i], heap[j]);
+    position[qMakePair(heap[i].chord1_id, heap[i].chord2_id)] = i;
+    position[qMakePair(heap[j].chord1_id, heap[j].chord2_id)] = j;
+}
@@ -0,0 +1,44 @@
+#ifndef RECOMMENDER_H
+#define RECOMMENDER_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include "analytics.h"
+#include "models.h"
+
+
+class Recommender
+{
+public:
+    Recommender();
+
+    void setPairs(const QList<Chord> &chords, const QHash<QPair<int, int>, ChordPair> &pairs);
+    void update(const ChordPair &pair, const PairStats &stats);
+    void rescore();
+    ChordPair next(const ChordPair &current);
+
+private:
+    // a pair in the heap, which may not have been stored yet, with the slope of its counts
+    struct Entry
+    {
+        int chord1_id, chord2_id, pair_id, latest_count;
+        qint64 latest_time;
+        double slope, score;
+    };
+
+    double score(const Entry &entry) const;
+    void siftUp(int i);
+    void siftDown(int i);
+    void swap(int i, int j);
+
+    // max heap on score, plus position of every pair in it
+    QVector<Entry> heap;
+    QHash<QPair<int, int>, int> position;
+
+    // time the scores have been computed for
+    qint64 now;
+};
+
+#endif // RECOMMENDER_H
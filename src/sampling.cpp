@@ -0,0 +1,51 @@
+#include "sampling.h"
+
+#include <algorithm>
+
+void Sampling::minMax(const QVector<double> &x, const QVector<double> &y, double lower, double upper, int buckets,
+                      QVector<double> &outX, QVector<double> &outY)
+{
+    // clear output
+    outX.clear();
+    outY.clear();
+
+    // find visible points, x is sorted
+    int first = std::lower_bound(x.constBegin(), x.constEnd(), lower) - x.constBegin();
+    int last = std::upper_bound(x.constBegin(), x.constEnd(), upper) - x.constBegin();
+    int n = last - first;
+    if (n <= 0)
+        return;
+
+    // few enough points? then take them all
+    if (buckets <= 0 || n <= 2 * buckets || upper <= lower) {
+        outX = x.mid(first, n);
+        outY = y.mid(first, n);
+        return;
+    }
+
+    // keep the lowest and highest point of every bucket, in order of x
+    outX.reserve(2 * buckets);
+    outY.reserve(2 * buckets);
+    double width = (upper - lower) / buckets;
+    int i = first;
+    while (i < last) {
+        // all points in this bucket
+        int bucket = std::min(buckets - 1, int((x[i] - lower) / width));
+        int iMin = i, iMax = i;
+        for (++i; i < last && std::min(buckets - 1, int((x[i] - lower) / width)) == bucket; ++i) {
+            if (y[i] < y[iMin])
+                iMin = i;
+            if (y[i] > y[iMax])
+                iMax = i;
+        }
+
+        // add them
+        int a = std::min(iMin, iMax), b = std::max(iMin, iMax);
+        outX.append(x[a]);
+        outY.append(y[a]);
+        if (b != a) {
+            outX.append(x[b]);
+            outY.append(y[b]);
+        }
+    }
+}
@@ -0,0 +1,14 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <QVector>
+
+
+class Sampling
+{
+public:
+    static void minMax(const QVector<double> &x, const QVector<double> &y, double lower, double upper, int buckets,
+                       QVector<double> &outX, QVector<double> &outY);
+};
+
+#endif // SAMPLING_H
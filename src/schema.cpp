@@ -0,0 +1,177 @@
+#include "schema.h"
+
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+static bool hasColumn(QSqlQuery &query, const QString &table, const QString &column)
+{
+    // check table info for column
+    if (query.exec(QString("PRAGMA table_info(%1);").arg(table))) {
+        while (query.next()) {
+            if (query.value(1).toString() == column)
+                return true;
+        }
+    }
+    return false;
+}
+
+static bool updateSummaries(QSqlQuery &query)
+{
+    // recalculate summary in chordpair from all counts
+    return query.exec("UPDATE chordpair SET "
+                      "  latest_count=(SELECT count FROM chordcount WHERE chords_id=chordpair.id "
+                      "                ORDER BY time DESC, id DESC LIMIT 1), "
+                      "  latest_time=(SELECT MAX(time) FROM chordcount WHERE chords_id=chordpair.id), "
+                      "  sessions=(SELECT COUNT(*) FROM chordcount WHERE chords_id=chordpair.id);");
+}
+
+static bool migrateTables(QSqlQuery &query)
+{
+    // create tables, might already exist in databases from before versioning
+    return query.exec("CREATE TABLE IF NOT EXISTS chord ("
+                      "  id INTEGER NOT NULL, "
+                      "  name VARCHAR(20) NOT NULL, "
+                      "  PRIMARY KEY (id)"
+                      ");")
+        && query.exec("CREATE TABLE IF NOT EXISTS chordcount ("
+                      "  id INTEGER NOT NULL,"
+                      "  chords_id INTEGER, "
+                      "  time DATETIME NOT NULL, "
+                      "  count INTEGER, "
+                      "  PRIMARY KEY (id), "
+                      "  FOREIGN KEY(chords_id) REFERENCES chordpair (id)"
+                      ");")
+        && query.exec("CREATE TABLE IF NOT EXISTS chordpair ("
+                      "  id INTEGER NOT NULL, "
+                      "  chord1_id INTEGER, "
+                      "  chord2_id INTEGER, "
+                      "  PRIMARY KEY (id), "
+                      "  FOREIGN KEY(chord1_id) REFERENCES chord (id),"
+                      "  FOREIGN KEY(chord2_id) REFERENCES chord (id)"
+                      ");");
+}
+
+static bool migrateSummary(QSqlQuery &query)
+{
+    // add summary of latest count to chordpair, if it doesn't exist yet
+    if (!hasColumn(query, "chordpair", "latest_count")) {
+        if (!query.exec("ALTER TABLE chordpair ADD COLUMN latest_count INTEGER;")
+                || !query.exec("ALTER TABLE chordpair ADD COLUMN latest_time DATETIME;")
+                || !query.exec("ALTER TABLE chordpair ADD COLUMN sessions INTEGER NOT NULL DEFAULT 0;"))
+            return false;
+    }
+
+    // fill it
+    if (!updateSummaries(query))
+        return false;
+
+    // keep summary up to date on changes in chordcount
+    return query.exec("CREATE TRIGGER IF NOT EXISTS chordcount_insert AFTER INSERT ON chordcount BEGIN "
+                      "  UPDATE chordpair SET "
+                      "    sessions=sessions+1, "
+                      "    latest_count=CASE WHEN latest_time IS NULL OR NEW.time>=latest_time "
+                      "                      THEN NEW.count ELSE latest_count END, "
+                      "    latest_time=CASE WHEN latest_time IS NULL OR NEW.time>=latest_time "
+                      "                     THEN NEW.time ELSE latest_time END "
+                      "  WHERE id=NEW.chords_id; "
+                      "END;")
+        && query.exec("CREATE TRIGGER IF NOT EXISTS chordcount_delete AFTER DELETE ON chordcount BEGIN "
+                      "  UPDATE chordpair SET "
+                      "    sessions=sessions-1, "
+                      "    latest_count=(SELECT count FROM chordcount WHERE chords_id=OLD.chords_id "
+                      "                  ORDER BY time DESC, id DESC LIMIT 1), "
+                      "    latest_time=(SELECT MAX(time) FROM chordcount WHERE chords_id=OLD.chords_id) "
+                      "  WHERE id=OLD.chords_id; "
+                      "END;");
+}
+
+static bool migrateIndexes(QSqlQuery &query)
+{
+    // move counts of duplicate pairs to the oldest one, so that pairs can be made unique
+    if (!query.exec("UPDATE chordcount SET chords_id=("
+                    "  SELECT MIN(p2.id) FROM chordpair p1 "
+                    "  JOIN chordpair p2 ON p1.chord1_id=p2.chord1_id AND p1.chord2_id=p2.chord2_id "
+                    "  WHERE p1.id=chordcount.chords_id"
+                    ") WHERE chords_id IN ("
+                    "  SELECT id FROM chordpair WHERE id NOT IN "
+                    "    (SELECT MIN(id) FROM chordpair GROUP BY chord1_id, chord2_id)"
+                    ");")
+            || !query.exec("DELETE FROM chordpair WHERE id NOT IN "
+                           "  (SELECT MIN(id) FROM chordpair GROUP BY chord1_id, chord2_id);")
+            || !updateSummaries(query))
+        return false;
+
+    // create indexes, the one on chordcount covers the whole history query
+    return query.exec("CREATE INDEX IF NOT EXISTS chordcount_pair_time ON chordcount (chords_id, time, count);")
+        && query.exec("CREATE UNIQUE INDEX IF NOT EXISTS chordpair_chords ON chordpair (chord1_id, chord2_id);")
+        && query.exec("CREATE INDEX IF NOT EXISTS chord_name ON chord (name);");
+}
+
+static bool migrateEpochTimes(QSqlQuery &query)
+{
+    // convert local time text written by QDateTime into milliseconds since epoch
+    return query.exec("UPDATE chordcount "
+                      "SET time=CAST(ROUND((julianday(time, 'utc') - 2440587.5) * 86400000.0) AS INTEGER) "
+                      "WHERE typeof(time)='text' AND julianday(time) IS NOT NULL;")
+        && updateSummaries(query);
+}
+
+static bool migrateHistoryIndex(QSqlQuery &query)
+{
+    // include id in index, so that paging newest first by (time, id) needs no sorting
+    return query.exec("DROP INDEX IF EXISTS chordcount_pair_time;")
+        && query.exec("CREATE INDEX IF NOT EXISTS chordcount_pair_time_id ON chordcount (chords_id, time, id, count);");
+}
+
+// all migrations in order, the schema version is the number of migrations applied
+static bool (*const MIGRATIONS[])(QSqlQuery &) = {
+    migrateTables,      // 1
+    migrateSummary,     // 2
+    migrateIndexes,     // 3
+    migrateEpochTimes,  // 4
+    migrateHistoryIndex,// 5
+};
+
+int Schema::version(QSqlDatabase &db)
+{
+    // get version from database
+    QSqlQuery query(db);
+    if (query.exec("PRAGMA user_version;") && query.first())
+        return query.value(0).toInt();
+    return -1;
+}
+
+int Schema::latestVersion()
+{
+    return sizeof(MIGRATIONS) / sizeof(MIGRATIONS[0]);
+}
+
+bool Schema::migrate(QSqlDatabase &db)
+{
+    // get current version
+    int current = version(db);
+    if (current < 0)
+        return false;
+
+    // run all missing migrations, each in its own transaction
+    QSqlQuery query(db);
+    for (int v = current + 1; v <= latestVersion(); ++v) {
+        // start transaction
+        if (!db.transaction())
+            return false;
+
+        // migrate and set new version
+        if (!MIGRATIONS[v - 1](query) || !query.exec(QString("PRAGMA user_version=%1;").arg(v))) {
+            qWarning() << "Migration to schema version" << v << "failed:" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+
+        // commit
+        if (!db.commit())
+            return false;
+    }
+    return true;
+}
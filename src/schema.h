@@ -0,0 +1,15 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <QSqlDatabase>
+
+
+class Schema
+{
+public:
+    static int version(QSqlDatabase &db);
+    static int latestVersion();
+    static bool migrate(QSqlDatabase &db);
+};
+
+#endif // SCHEMA_H
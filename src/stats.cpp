@@ -0,0 +1,97 @@
+#include "stats.h"
+
+#include <vector>
+
+// number of independent accumulators in reductions, which lets the compiler use vector
+// registers without having to reorder floating point additions itself
+static const int LANES = 4;
+
+double Stats::mean(const double *y, int n)
+{
+    // nothing?
+    if (n <= 0)
+        return 0.;
+
+    // sum in lanes
+    double sum[LANES] = {0., 0., 0., 0.};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (int l = 0; l < LANES; ++l)
+            sum[l] += y[i + l];
+    }
+    for (; i < n; ++i)
+        sum[0] += y[i];
+    return (sum[0] + sum[1] + sum[2] + sum[3]) / n;
+}
+
+void Stats::rollingMean(const double *y, int n, int window, double *out)
+{
+    // nothing?
+    if (n <= 0 || window <= 0)
+        return;
+
+    // prefix sums, so that every mean is a single difference
+    std::vector<double> sum(n + 1);
+    sum[0] = 0.;
+    for (int i = 0; i < n; ++i)
+        sum[i + 1] = sum[i] + y[i];
+
+    // first values average over what is there so far
+    int head = window < n ? window : n;
+    for (int i = 0; i < head; ++i)
+        out[i] = sum[i + 1] / (i + 1);
+
+    // independent differences for the rest
+    const double *upper = sum.data() + window + 1, *lower = sum.data() + 1;
+    double scale = 1. / window;
+    for (int i = window; i < n; ++i)
+        out[i] = (upper[i - window] - lower[i - window]) * scale;
+}
+
+void Stats::ewma(const double *y, int n, double alpha, double *out)
+{
+    // nothing?
+    if (n <= 0)
+        return;
+
+    // recurrence starts at first value
+    out[0] = y[0];
+    double beta = 1. - alpha;
+    for (int i = 1; i < n; ++i)
+        out[i] = alpha * y[i] + beta * out[i - 1];
+}
+
+bool Stats::linearFit(const double *x, const double *y, int n, double *slope, double *intercept)
+{
+    // need at least two points
+    if (n < 2)
+        return false;
+
+    // fit around the means for numerical stability
+    double mx = mean(x, n), my = mean(y, n);
+    double sxy[LANES] = {0., 0., 0., 0.}, sxx[LANES] = {0., 0., 0., 0.};
+    int i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (int l = 0; l < LANES; ++l) {
+            double dx = x[i + l] - mx;
+            sxy[l] += dx * (y[i + l] - my);
+            sxx[l] += dx * dx;
+        }
+    }
+    for (; i < n; ++i) {
+        double dx = x[i] - mx;
+        sxy[0] += dx * (y[i] - my);
+        sxx[0] += dx * dx;
+    }
+
+    // all x equal?
+    double covariance = sxy[0] + sxy[1] + sxy[2] + sxy[3];
+    double variance = sxx[0] + sxx[1] + sxx[2] + sxx[3];
+    if (variance <= 0.)
+        return false;
+
+    // results
+    *slope = covariance / variance;
+    *intercept = my - *slope * mx;
+    return true;
+}
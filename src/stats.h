@@ -0,0 +1,15 @@
+#ifndef STATS_H
+#define STATS_H
+
+
+// statistics on contiguous arrays of doubles, written so that the compiler can vectorize the loops
+class Stats
+{
+public:
+    static double mean(const double *y, int n);
+    static void rollingMean(const double *y, int n, int window, double *out);
+    static void ewma(const double *y, int n, double alpha, double *out);
+    static bool linearFit(const double *x, const double *y, int n, double *slope, double *intercept);
+};
+
+#endif // STATS_H
@@ -0,0 +1,113 @@
+#include "wavfile.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+bool WavFile::read(const QString &filename, QVector<float> *samples, int *sampleRate)
+{
+    // open file
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    // RIFF header
+    char id[4];
+    quint32 size;
+    if (stream.readRawData(id, 4) != 4 || std::memcmp(id, "RIFF", 4) != 0)
+        return false;
+    stream >> size;
+    if (stream.readRawData(id, 4) != 4 || std::memcmp(id, "WAVE", 4) != 0)
+        return false;
+
+    // go through chunks until data, format must come first
+    quint16 format = 0, channels = 0, bits = 0;
+    quint32 rate = 0;
+    while (stream.readRawData(id, 4) == 4) {
+        stream >> size;
+        if (std::memcmp(id, "fmt ", 4) == 0) {
+            // PCM or float, extensible format has the actual one at start of its sub format
+            quint32 byteRate;
+            quint16 blockAlign, extension, validBits;
+            quint32 channelMask;
+            stream >> format >> channels >> rate >> byteRate >> blockAlign >> bits;
+            quint32 consumed = 16;
+            if (format == 0xFFFE && size >= 26) {
+                stream >> extension >> validBits >> channelMask >> format;
+                consumed = 26;
+            }
+
+            // skip rest of chunk, i.e. remaining bytes of sub format GUID, padded to even size
+            file.seek(file.pos() + (size - std::min(size, consumed)) + (size & 1));
+        }
+        else if (std::memcmp(id, "data", 4) == 0) {
+            // supported?
+            if (channels == 0 || !((format == 1 && (bits == 16 || bits == 24 || bits == 32)) || (format == 3 && bits == 32)))
+                return false;
+
+            // read all frames, data size may be wrong in files that were written while recording
+            QByteArray data = file.read(size);
+            int bytes = bits / 8, frames = data.size() / (bytes * channels);
+            auto raw = reinterpret_cast<const uchar*>(data.constData());
+            samples->resize(frames);
+
+            // convert to float and mix down to mono
+            float scale = 1.f / channels;
+            for (int i = 0; i < frames; ++i) {
+                float sum = 0.f;
+                for (int c = 0; c < channels; ++c, raw += bytes) {
+                    if (format == 3) {
+                        quint32 value = qFromLittleEndian<quint32>(raw);
+                        float sample;
+                        std::memcpy(&sample, &value, sizeof(sample));
+                        sum += sample;
+                    }
+                    else if (bits == 16)
+                        sum += qFromLittleEndian<qint16>(raw) / 32768.f;
+                    else if (bits == 24)
+                        sum += qint32(quint32(raw[0]) << 8 | quint32(raw[1]) << 16 | quint32(raw[2]) << 24) / 2147483648.f;
+                    else
+                        sum += qFromLittleEndian<qint32>(raw) / 2147483648.f;
+                }
+                (*samples)[i] = sum * scale;
+            }
+            *sampleRate = int(rate);
+            return true;
+        }
+        else {
+            // skip unknown chunk, which is padded to even size
+            file.seek(file.pos() + size + (size & 1));
+        }
+    }
+    return false;
+}
+
+bool WavFile::write(const QString &filename, const QVector<qint16> &samples, int sampleRate)
+{
+    // open file
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    // RIFF header and format chunk for 16 bit mono PCM
+    quint32 dataSize = quint32(samples.size()) * 2;
+    stream.writeRawData("RIFF", 4);
+    stream << quint32(36 + dataSize);
+    stream.writeRawData("WAVEfmt ", 8);
+    stream << quint32(16) << quint16(1) << quint16(1) << quint32(sampleRate) << quint32(sampleRate * 2)
+           << quint16(2) << quint16(16);
+
+    // samples
+    stream.writeRawData("data", 4);
+    stream << dataSize;
+    foreach (auto sample, samples) {
+        stream << sample;
+    }
+    return stream.status() == QDataStream::Ok;
+}
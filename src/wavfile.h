@@ -0,0 +1,15 @@
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <QString>
+#include <QVector>
+
+
+class WavFile
+{
+public:
+    static bool read(const QString &filename, QVector<float> *samples, int *sampleRate);
+    static bool write(const QString &filename, const QVector<qint16> &samples, int sampleRate);
+};
+
+#endif // WAVFILE_H
@@ -0,0 +1,21 @@
+#include "worker.h"
+#include "database.h"
+
+QThreadPool *Worker::pool()
+{
+    // a single thread that never expires, so that all calls share one connection
+    static QThreadPool *pool = nullptr;
+    if (!pool) {
+        pool = new QThreadPool();
+        pool->setMaxThreadCount(1);
+        pool->setExpiryTimeout(-1);
+    }
+    return pool;
+}
+
+void Worker::shutdown()
+{
+    // close connection on the worker thread and wait for everything to finish
+    run([]() { Database::closeConnection(); return true; }).waitForFinished();
+    pool()->waitForDone();
+}
@@ -0,0 +1,25 @@
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <QFuture>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+
+class Worker
+{
+public:
+    // run function on the database thread, which uses its own connection
+    template <typename F>
+    static auto run(F function) -> QFuture<decltype(function())>
+    {
+        return QtConcurrent::run(pool(), function);
+    }
+
+    static void shutdown();
+
+private:
+    static QThreadPool *pool();
+};
+
+#endif // WORKER_H
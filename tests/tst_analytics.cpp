@@ -0,0 +1,196 @@
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QSqlQuery>
+#include <QtTest>
+#include <cmath>
+#include "analytics.h"
+#include "database.h"
+#include "models.h"
+#include "schema.h"
+
+
+class TestAnalytics : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+    void slopeOfSteadyProgress();
+    void createAndRemoveUpdateAggregates();
+    void randomChangesMatchReload();
+
+private:
+    ChordCount insert(int pair_id, qint64 time, int count);
+    bool remove(const ChordCount &count);
+    static void compare(const QList<PairStats> &incremental, const QList<PairStats> &loaded);
+
+    QList<int> pairIds;
+};
+
+void TestAnalytics::initTestCase()
+{
+    // empty database in memory, with the full schema
+    QVERIFY(Database::open(":memory:"));
+    QSqlDatabase db = QSqlDatabase::database();
+    QVERIFY(Schema::migrate(db));
+
+    // all pairs of four chords
+    QList<Chord> chords;
+    foreach (auto name, QStringList({"A", "C", "D", "G"})) {
+        chords.append(Chord::getOrCreate(name));
+        QVERIFY(chords.last().id >= 0);
+    }
+    for (int i = 0; i < chords.length(); ++i) {
+        for (int j = i + 1; j < chords.length(); ++j) {
+            auto pair = ChordPair::getOrCreate(chords[i].id, chords[j].id);
+            QVERIFY(pair.exists());
+            pairIds.append(pair.id);
+        }
+    }
+}
+
+void TestAnalytics::init()
+{
+    // every test starts without counts
+    QSqlQuery query;
+    QVERIFY(query.exec("DELETE FROM chordcount"));
+    Analytics::load();
+    QVERIFY(Analytics::isLoaded());
+}
+
+void TestAnalytics::cleanupTestCase()
+{
+    Database::clearStatements(QSqlDatabase::database().connectionName());
+}
+
+ChordCount TestAnalytics::insert(int pair_id, qint64 time, int count)
+{
+    // store count at given time, and tell analytics like ChordCount::create() does after commit
+    QSqlQuery query;
+    query.prepare("INSERT INTO chordcount (chords_id, time, count) VALUES (:id, :time, :count)");
+    query.bindValue(":id", pair_id);
+    query.bindValue(":time", time);
+    query.bindValue(":count", count);
+    if (!query.exec())
+        return ChordCount(-1, pair_id, time, count);
+    ChordCount created(query.lastInsertId().toInt(), pair_id, time, count);
+    Analytics::countAdded(created);
+    return created;
+}
+
+bool TestAnalytics::remove(const ChordCount &count)
+{
+    // delete count, and tell analytics like ChordCount::remove() does after commit
+    QSqlQuery query;
+    query.prepare("DELETE FROM chordcount WHERE id=:id");
+    query.bindValue(":id", count.id);
+    if (!query.exec())
+        return false;
+    Analytics::countRemoved(count);
+    return true;
+}
+
+void TestAnalytics::compare(const QList<PairStats> &incremental, const QList<PairStats> &loaded)
+{
+    // same pairs
+    QHash<int, PairStats> expected;
+    foreach (auto stats, loaded) {
+        expected.insert(stats.pair_id, stats);
+    }
+    QCOMPARE(incremental.size(), expected.size());
+
+    // same stats, up to rounding in the sums
+    foreach (auto stats, incremental) {
+        QVERIFY(expected.contains(stats.pair_id));
+        auto other = expected[stats.pair_id];
+        QCOMPARE(stats.sessions, other.sessions);
+        QCOMPARE(stats.min, other.min);
+        QCOMPARE(stats.max, other.max);
+        QCOMPARE(stats.last_time, other.last_time);
+        QVERIFY(std::abs(stats.mean - other.mean) <= 1e-9 * std::max(1., std::abs(other.mean)));
+        QVERIFY(std::abs(stats.slope - other.slope) <= 1e-6 * std::max(1., std::abs(other.slope)));
+    }
+}
+
+void TestAnalytics::slopeOfSteadyProgress()
+{
+    // two more changes every day for a month, starting a year ago
+    qint64 start = QDateTime::currentMSecsSinceEpoch() - 365 * 86400000LL;
+    for (int day = 0; day < 30; ++day)
+        QVERIFY(insert(pairIds[0], start + day * 86400000LL, 10 + 2 * day).exists());
+
+    // exact fit
+    PairStats stats;
+    QVERIFY(Analytics::pair(pairIds[0], &stats));
+    QCOMPARE(stats.sessions, 30);
+    QCOMPARE(stats.min, 10);
+    QCOMPARE(stats.max, 68);
+    QVERIFY(std::abs(stats.mean - 39.) < 1e-9);
+    QVERIFY(std::abs(stats.slope - 2.) < 1e-9);
+    QCOMPARE(stats.last_time, start + 29 * 86400000LL);
+}
+
+void TestAnalytics::createAndRemoveUpdateAggregates()
+{
+    // counts stored through the models reach analytics once committed
+    auto first = ChordCount::create(pairIds[1], 20);
+    auto second = ChordCount::create(pairIds[1], 30);
+    QVERIFY(first.exists() && second.exists());
+    PairStats stats;
+    QVERIFY(Analytics::pair(pairIds[1], &stats));
+    QCOMPARE(stats.sessions, 2);
+    QCOMPARE(stats.max, 30);
+
+    // nothing changes for a rolled back count
+    {
+        Transaction transaction;
+        QVERIFY(ChordCount::create(pairIds[1], 50).exists());
+        transaction.rollback();
+    }
+    QVERIFY(Analytics::pair(pairIds[1], &stats));
+    QCOMPARE(stats.sessions, 2);
+    QCOMPARE(stats.max, 30);
+
+    // removing the maximum fetches the extremes again
+    QVERIFY(ChordCount::remove(second.id));
+    QVERIFY(Analytics::pair(pairIds[1], &stats));
+    QCOMPARE(stats.sessions, 1);
+    QCOMPARE(stats.min, 20);
+    QCOMPARE(stats.max, 20);
+
+    // pair without counts has no stats
+    QVERIFY(ChordCount::remove(first.id));
+    QVERIFY(!Analytics::pair(pairIds[1], &stats));
+}
+
+void TestAnalytics::randomChangesMatchReload()
+{
+    // reproducible mix of adds and removes over ten years
+    QRandomGenerator random(42);
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<ChordCount> stored;
+    for (int step = 1; step <= 2000; ++step) {
+        if (stored.isEmpty() || random.bounded(10) < 6) {
+            int pair_id = pairIds[random.bounded(pairIds.size())];
+            qint64 time = now - random.bounded(quint32(3650)) * 86400000LL - random.bounded(86400000);
+            auto count = insert(pair_id, time, random.bounded(100));
+            QVERIFY(count.exists());
+            stored.append(count);
+        }
+        else {
+            QVERIFY(remove(stored.takeAt(random.bounded(stored.size()))));
+        }
+
+        // incremental aggregates must match a fresh scan, which then becomes the new starting point
+        if (step % 250 == 0) {
+            auto incremental = Analytics::pairs();
+            Analytics::load();
+            compare(incremental, Analytics::pairs());
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestAnalytics)
+#include "tst_analytics.moc"
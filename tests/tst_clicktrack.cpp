@@ -0,0 +1,101 @@
+#include <QTemporaryDir>
+#include <QtTest>
+#include <cmath>
+#include "clicktrack.h"
+#include "wavfile.h"
+
+
+class TestClickTrack : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void clicksStartOnTheirSamples();
+    void ringBufferWraps();
+    void renderWavMatchesTrack();
+
+private:
+    static QVector<qint64> expectedOnsets(int sampleRate, double bpm);
+};
+
+QVector<qint64> TestClickTrack::expectedOnsets(int sampleRate, double bpm)
+{
+    // countdown every second, "GO!" after three seconds, then beats until end of session
+    QVector<qint64> onsets = {0, sampleRate, 2 * sampleRate};
+    qint64 go = 3 * sampleRate;
+    onsets.append(go);
+    for (int k = 1; go + std::llround(k * 60. * sampleRate / bpm) < 60 * sampleRate; ++k)
+        onsets.append(go + std::llround(k * 60. * sampleRate / bpm));
+    return onsets;
+}
+
+void TestClickTrack::clicksStartOnTheirSamples()
+{
+    // a tempo that doesn't divide the sample rate, so rounding would show
+    const int rate = 48000;
+    const double bpm = 97.;
+    ClickTrack track(rate, bpm);
+    QCOMPARE(track.length(), qint64(60 * rate));
+
+    // render in odd chunks, like the audio output would ask for
+    QVector<qint16> out(track.length());
+    for (qint64 pos = 0; pos < track.length(); pos += 333)
+        track.render(out.data() + pos, pos, int(std::min<qint64>(333, track.length() - pos)));
+
+    // every click is silent right before its onset and sounds right after it
+    foreach (auto onset, expectedOnsets(rate, bpm)) {
+        if (onset > 0)
+            QCOMPARE(out[onset - 1], qint16(0));
+        QCOMPARE(out[onset], qint16(0));
+        QVERIFY(out[onset + 1] != 0);
+    }
+}
+
+void TestClickTrack::ringBufferWraps()
+{
+    // capacity is rounded up to a power of two
+    RingBuffer ring(5);
+    QCOMPARE(ring.space(), 8);
+
+    // write and read across the end of the buffer several times
+    qint16 in[6], out[6];
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 6; ++i)
+            in[i] = qint16(round * 6 + i);
+        QCOMPARE(ring.write(in, 6), 6);
+        QCOMPARE(ring.write(in, 6), 2);
+        QCOMPARE(ring.read(out, 6), 6);
+        for (int i = 0; i < 6; ++i)
+            QCOMPARE(out[i], in[i]);
+        QCOMPARE(ring.read(out, 6), 2);
+    }
+    QCOMPARE(ring.available(), 0);
+}
+
+void TestClickTrack::renderWavMatchesTrack()
+{
+    // render to file
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString filename = dir.filePath("clicks.wav");
+    QVERIFY(ClickTrack::renderWav(filename, 60.));
+
+    // read it back
+    QVector<float> samples;
+    int rate;
+    QVERIFY(WavFile::read(filename, &samples, &rate));
+    QCOMPARE(rate, int(ClickTrack::SAMPLE_RATE));
+
+    // same samples as rendering directly
+    ClickTrack track(rate, 60.);
+    QVector<qint16> out(track.length());
+    track.render(out.data(), 0, int(out.size()));
+    QCOMPARE(samples.size(), out.size());
+    for (int i = 0; i < out.size(); ++i) {
+        if (samples[i] != out[i] / 32768.f)
+            QFAIL(qPrintable(QString("Sample %1 differs").arg(i)));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestClickTrack)
+#include "tst_clicktrack.moc"
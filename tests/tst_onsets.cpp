@@ -0,0 +1,158 @@
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include <cmath>
+#include "clicktrack.h"
+#include "onsets.h"
+#include "wavfile.h"
+
+
+class TestOnsets : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void readsPcm16();
+    void readsExtensible24();
+    void readsExtensibleFloat();
+    void skipsUnknownChunks();
+    void rejectsUnsupported();
+    void countsChangesOfSession();
+
+private:
+    QString fixture(quint16 format, quint16 bits, quint16 channels, bool extensible,
+                    const QByteArray &data, bool extraChunk = false);
+
+    QTemporaryDir dir;
+    int files;
+};
+
+void TestOnsets::init()
+{
+    QVERIFY(dir.isValid());
+    files = 0;
+}
+
+QString TestOnsets::fixture(quint16 format, quint16 bits, quint16 channels, bool extensible,
+                            const QByteArray &data, bool extraChunk)
+{
+    // header as written by common recorders, extensible with the actual format in its sub format GUID
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    quint32 fmtSize = extensible ? 40 : 16;
+    quint16 blockAlign = channels * bits / 8;
+    stream.writeRawData("RIFF", 4);
+    stream << quint32(4 + 8 + fmtSize + (extraChunk ? 8 + 5 + 1 : 0) + 8 + data.size());
+    stream.writeRawData("WAVEfmt ", 8);
+    stream << fmtSize << quint16(extensible ? 0xFFFE : format) << channels << quint32(48000)
+           << quint32(48000 * blockAlign) << blockAlign << bits;
+    if (extensible) {
+        stream << quint16(22) << bits << quint32(channels == 2 ? 3 : 4) << format;
+        stream.writeRawData("\x00\x00\x00\x00\x10\x00\x80\x00\x00\xAA\x00\x38\x9B\x71", 14);
+    }
+
+    // odd sized chunk, which is padded
+    if (extraChunk) {
+        stream.writeRawData("LIST", 4);
+        stream << quint32(5);
+        stream.writeRawData("INFO\x01\x00", 6);
+    }
+
+    // samples
+    stream.writeRawData("data", 4);
+    stream << quint32(data.size());
+    stream.writeRawData(data.constData(), data.size());
+
+    // write to file
+    QString filename = dir.filePath(QString("fixture%1.wav").arg(files++));
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size())
+        return QString();
+    return filename;
+}
+
+void TestOnsets::readsPcm16()
+{
+    // three mono samples
+    QByteArray data("\x00\x40\x00\xC0\xFF\x7F", 6);
+    QVector<float> samples;
+    int rate;
+    QVERIFY(WavFile::read(fixture(1, 16, 1, false, data), &samples, &rate));
+    QCOMPARE(rate, 48000);
+    QCOMPARE(samples, QVector<float>({0.5f, -0.5f, 32767.f / 32768.f}));
+}
+
+void TestOnsets::readsExtensible24()
+{
+    // two stereo frames, mixed down to mono
+    QByteArray data("\x00\x00\x40\x00\x00\x20" "\x00\x00\xC0\x00\x00\xC0", 12);
+    QVector<float> samples;
+    int rate;
+    QVERIFY(WavFile::read(fixture(1, 24, 2, true, data), &samples, &rate));
+    QCOMPARE(samples, QVector<float>({0.375f, -0.5f}));
+}
+
+void TestOnsets::readsExtensibleFloat()
+{
+    // 0.25 and -1 as little endian floats
+    QByteArray data("\x00\x00\x80\x3E" "\x00\x00\x80\xBF", 8);
+    QVector<float> samples;
+    int rate;
+    QVERIFY(WavFile::read(fixture(3, 32, 1, true, data), &samples, &rate));
+    QCOMPARE(samples, QVector<float>({0.25f, -1.f}));
+}
+
+void TestOnsets::skipsUnknownChunks()
+{
+    // odd sized chunk between format and data
+    QByteArray data("\x00\x40", 2);
+    QVector<float> samples;
+    int rate;
+    QVERIFY(WavFile::read(fixture(1, 16, 1, true, data, true), &samples, &rate));
+    QCOMPARE(samples, QVector<float>({0.5f}));
+}
+
+void TestOnsets::rejectsUnsupported()
+{
+    // 8 bit
+    QVector<float> samples;
+    int rate;
+    QVERIFY(!WavFile::read(fixture(1, 8, 1, false, QByteArray("\x80\x80", 2)), &samples, &rate));
+}
+
+void TestOnsets::countsChangesOfSession()
+{
+    // click track at 50 bpm, so that no click lies on the end of the session, running for 70 s
+    // after half a second of silence, like a recording started before the countdown
+    ClickTrack track(ClickTrack::SAMPLE_RATE, 50., 3000, 70000);
+    int lead = ClickTrack::SAMPLE_RATE / 2;
+    QVector<qint16> out(lead + track.length(), 0);
+    track.render(out.data() + lead, 0, int(track.length()));
+
+    // through a WAV file, like a recording
+    QString filename = dir.filePath("session.wav");
+    QVERIFY(WavFile::write(filename, out, ClickTrack::SAMPLE_RATE));
+    QVector<float> samples;
+    int rate;
+    QVERIFY(WavFile::read(filename, &samples, &rate));
+
+    // feed it in chunks of 10 ms
+    OnsetDetector detector(rate);
+    for (int pos = 0; pos < samples.size(); pos += 480)
+        detector.process(samples.constData() + pos, int(std::min<qint64>(480, samples.size() - pos)));
+    detector.finish();
+
+    // 3 countdown clicks, "GO!" and 55 beats, all within 20 ms of their time
+    QCOMPARE(int(detector.onsets().size()), 59);
+    QVERIFY(std::abs(detector.onsets().front() - 0.5) < 0.02);
+
+    // first minute after first click: 4 clicks and 47 beats, the first one being the starting chord
+    QCOMPARE(detector.changes(60.), 50);
+}
+
+QTEST_GUILESS_MAIN(TestOnsets)
+#include "tst_onsets.moc"
@@ -0,0 +1,183 @@
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSqlQuery>
+#include <QTableView>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include "database.h"
+#include "mainwindow.h"
+#include "models.h"
+#include "schema.h"
+#include "worker.h"
+
+// chords, and days and counts of history per pair
+static const int CHORDS = 10;
+static const int DAYS = 180;
+static const int COUNTS = 60;
+
+
+class TestPlot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void replotStaysFlat();
+    void clickThroughPairs();
+
+private:
+    QList<QModelIndex> cells() const;
+    QString shownSeries() const;
+    bool select(const QModelIndex &index);
+    qint64 replotTime();
+
+    QTemporaryDir dir;
+    QSqlDatabase db;
+    MainWindow *window;
+    QTableView *table;
+    QCustomPlot *plot;
+};
+
+void TestPlot::initTestCase()
+{
+    // settings and database in temporary home, the worker needs a file to open its own connection
+    QVERIFY(dir.isValid());
+    qputenv("HOME", dir.path().toLocal8Bit());
+    QVERIFY(Database::open(dir.filePath("database.sqlite")));
+    db = QSqlDatabase::database();
+    QVERIFY(Database::configure(db));
+    QVERIFY(Schema::migrate(db));
+
+    // all pairs of some chords with half a year of history
+    QList<Chord> chords;
+    for (int i = 0; i < CHORDS; ++i)
+        chords.append(Chord::getOrCreate(QString("C%1").arg(i)));
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    Transaction transaction;
+    QSqlQuery insert;
+    insert.prepare("INSERT INTO chordcount (chords_id, time, count) VALUES (:id, :time, :count)");
+    for (int i = 0; i < CHORDS; ++i) {
+        for (int j = i + 1; j < CHORDS; ++j) {
+            auto pair = ChordPair::getOrCreate(chords[i].id, chords[j].id);
+            QVERIFY(pair.exists());
+            for (int k = 0; k < COUNTS; ++k) {
+                insert.bindValue(":id", pair.id);
+                insert.bindValue(":time", now - qint64(DAYS - k * DAYS / COUNTS) * 86400000);
+                insert.bindValue(":count", 20 + (k * 7 + i + j) % 40);
+                QVERIFY(insert.exec());
+            }
+        }
+    }
+    QVERIFY(transaction.commit());
+
+    // window of a usual size, offscreen when run by ctest
+    window = new MainWindow(&db);
+    window->resize(1200, 800);
+    window->show();
+    table = window->findChild<QTableView*>("tableChords");
+    plot = window->findChild<QCustomPlot*>("plotHistory");
+    QVERIFY(table && plot);
+    QTRY_COMPARE(table->model()->rowCount(), CHORDS - 1);
+}
+
+void TestPlot::cleanupTestCase()
+{
+    // window first, then worker and its statements
+    delete window;
+    Worker::shutdown();
+    Database::clearStatements(db.connectionName());
+}
+
+QList<QModelIndex> TestPlot::cells() const
+{
+    // all cells of the upper triangle
+    QList<QModelIndex> cells;
+    auto model = table->model();
+    for (int row = 0; row < model->rowCount(); ++row) {
+        for (int col = 0; col < model->columnCount(); ++col) {
+            auto index = model->index(row, col);
+            if (model->flags(index) & Qt::ItemIsSelectable)
+                cells.append(index);
+        }
+    }
+    return cells;
+}
+
+QString TestPlot::shownSeries() const
+{
+    // series have scatter points, trend lines don't
+    QStringList names;
+    for (int i = 0; i < plot->graphCount(); ++i) {
+        auto graph = plot->graph(i);
+        if (graph->visible() && graph->scatterStyle().shape() == QCPScatterStyle::ssCircle)
+            names.append(graph->name());
+    }
+    return names.size() == 1 ? names.first() : QString();
+}
+
+bool TestPlot::select(const QModelIndex &index)
+{
+    // click cell and wait until its series has replaced the previous one
+    auto previous = shownSeries();
+    table->setCurrentIndex(index);
+    return QTest::qWaitFor([this, previous]() {
+        auto shown = shownSeries();
+        return !shown.isEmpty() && shown != previous;
+    }, 5000);
+}
+
+qint64 TestPlot::replotTime()
+{
+    // median of a few immediate replots, in nanoseconds
+    QVector<qint64> times;
+    for (int i = 0; i < 5; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        plot->replot(QCustomPlot::rpImmediateRefresh);
+        times.append(timer.nsecsElapsed());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+void TestPlot::replotStaysFlat()
+{
+    // click through all pairs three times, loading them first and then from cache
+    auto all = cells();
+    QCOMPARE(all.size(), CHORDS * (CHORDS - 1) / 2);
+    QVector<qint64> times;
+    for (int pass = 0; pass < 3; ++pass) {
+        foreach (auto index, all) {
+            QVERIFY(select(index));
+
+            // trend lines plus one graph for the single selected pair, however many have been shown
+            QVERIFY2(plot->graphCount() <= 4, qPrintable(QString("%1 graphs in plot").arg(plot->graphCount())));
+            times.append(replotTime());
+        }
+    }
+
+    // last clicks replot as fast as the first ones, with some slack for noise
+    auto median = [](QVector<qint64> values) {
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    };
+    qint64 first = median(times.mid(0, 10)), last = median(times.mid(times.size() - 10));
+    QVERIFY2(last <= 2 * first + 2000000,
+             qPrintable(QString("replot took %1 us at first, %2 us at last").arg(first / 1000).arg(last / 1000)));
+}
+
+void TestPlot::clickThroughPairs()
+{
+    // selecting a cached pair and replotting it
+    auto all = cells();
+    int i = 0;
+    QBENCHMARK {
+        QVERIFY(select(all[i++ % all.size()]));
+        plot->replot(QCustomPlot::rpImmediateRefresh);
+    }
+}
+
+QTEST_MAIN(TestPlot)
+#include "tst_plot.moc"
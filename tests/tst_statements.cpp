@@ -0,0 +1,114 @@
+#include <QSqlQuery>
+#include <QtTest>
+#include "database.h"
+#include "models.h"
+#include "schema.h"
+
+// queries behind ChordPair::getOrCreate() for a stored pair, and ChordCount::listForPair()
+static const char *INSERT_PAIR = "INSERT OR IGNORE INTO chordpair (chord1_id, chord2_id) VALUES (:id1, :id2)";
+static const char *SELECT_PAIR = "SELECT id, chord1_id, chord2_id, latest_count, latest_time, sessions "
+                                 "FROM chordpair WHERE chord1_id=:id1 AND chord2_id=:id2";
+static const char *LIST_COUNTS = "SELECT id, time, count FROM chordcount WHERE chords_id=:id ORDER BY time ASC";
+
+
+class TestStatements : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void getOrCreatePooled();
+    void getOrCreateFresh();
+    void listForPairPooled();
+    void listForPairFresh();
+
+private:
+    ChordPair pair;
+};
+
+void TestStatements::initTestCase()
+{
+    // empty database in memory, with the full schema
+    QVERIFY(Database::open(":memory:"));
+    QSqlDatabase db = QSqlDatabase::database();
+    QVERIFY(Schema::migrate(db));
+
+    // a pair with a typical history
+    auto chord1 = Chord::getOrCreate("C"), chord2 = Chord::getOrCreate("G");
+    pair = ChordPair::getOrCreate(chord1.id, chord2.id);
+    QVERIFY(pair.exists());
+    Transaction transaction;
+    for (int i = 0; i < 100; ++i)
+        QVERIFY(ChordCount::create(pair.id, 20 + i % 40).exists());
+    QVERIFY(transaction.commit());
+}
+
+void TestStatements::cleanupTestCase()
+{
+    Database::clearStatements(QSqlDatabase::database().connectionName());
+}
+
+void TestStatements::getOrCreatePooled()
+{
+    // statements from the pool, as used by the models
+    QBENCHMARK {
+        Transaction transaction;
+        Statement insert(INSERT_PAIR);
+        insert->bindValue(":id1", pair.chord1_id);
+        insert->bindValue(":id2", pair.chord2_id);
+        QVERIFY(insert->exec());
+        Statement query(SELECT_PAIR);
+        query->bindValue(":id1", pair.chord1_id);
+        query->bindValue(":id2", pair.chord2_id);
+        QVERIFY(query->exec() && query->first());
+        query->finish();
+        QVERIFY(transaction.commit());
+    }
+}
+
+void TestStatements::getOrCreateFresh()
+{
+    // statements prepared on every call, as before the pool
+    QBENCHMARK {
+        Transaction transaction;
+        QSqlQuery insert;
+        insert.prepare(INSERT_PAIR);
+        insert.bindValue(":id1", pair.chord1_id);
+        insert.bindValue(":id2", pair.chord2_id);
+        QVERIFY(insert.exec());
+        QSqlQuery query;
+        query.prepare(SELECT_PAIR);
+        query.bindValue(":id1", pair.chord1_id);
+        query.bindValue(":id2", pair.chord2_id);
+        QVERIFY(query.exec() && query.first());
+        query.finish();
+        QVERIFY(transaction.commit());
+    }
+}
+
+void TestStatements::listForPairPooled()
+{
+    // the model method itself
+    QBENCHMARK {
+        QCOMPARE(ChordCount::listForPair(pair.id).size(), 100);
+    }
+}
+
+void TestStatements::listForPairFresh()
+{
+    // same query and conversion, prepared on every call
+    QBENCHMARK {
+        QList<ChordCount> counts;
+        QSqlQuery query;
+        query.prepare(LIST_COUNTS);
+        query.bindValue(":id", pair.id);
+        QVERIFY(query.exec());
+        while (query.next())
+            counts.append(ChordCount(query.value(0).toInt(), pair.id, query.value(1).toLongLong(), query.value(2).toInt()));
+        QCOMPARE(counts.size(), 100);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestStatements)
+#include "tst_statements.moc"